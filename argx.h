@@ -14,195 +14,4600 @@
 #include <list>
 #include <map>
 #include <stdexcept>
+#include <exception>
 #include <algorithm>
 #include <optional>
 #include <utility>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <memory>
+#include <vector>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <cstdio>
+#include <concepts>
+#include <tuple>
+#include <type_traits>
+#include <span>
+#include <iterator>
+#include <system_error>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <version>
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+#include <expected>
+#endif
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
+// Without exceptions (-fno-exceptions) every error that would throw aborts instead,
+// the try_ functions report errors as values in both modes
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define ARGX_EXCEPTIONS 1
+#define ARGX_THROW(error) throw error
+#else
+#define ARGX_EXCEPTIONS 0
+#define ARGX_THROW(error) (static_cast<void>(error), std::abort())
+#endif
 
 typedef std::list<std::string> string_list;
 typedef std::map<std::string, string_list> options_map;
 typedef std::initializer_list<std::string> string_il;
 
-namespace argx {
+namespace argx {
+
+    /**
+     * Canonical id of an option or flag registered in a Schema
+     */
+    enum class option_id : std::uint32_t {};
+
+    /**
+     * Which definition wins when a map option defines the same key twice
+     */
+    enum class Duplicates { last_wins, first_wins };
+
+    /**
+     * How a registered option keeps repeated occurrences
+     * append: every value (default), last: only the last value,
+     * first: only the first value, count: no value, only the number of occurrences
+     * The policy shapes the keyed accessors; ParseResult::tokens() still lists every occurrence.
+     */
+    enum class Storage { append, last, first, count };
+
+    /**
+     * Number of values an option takes per occurrence
+     * The values of an occurrence always stop at the next option or flag,
+     * so zero_or_more takes everything up to the next option.
+     */
+    struct Arity {
+        std::uint32_t min = 0;
+        std::uint32_t max = 1;
+
+        static constexpr Arity exactly(const std::uint32_t count) { return {count, count}; }
+        static constexpr Arity one_or_more() { return {1, UINT32_MAX}; }
+        static constexpr Arity zero_or_more() { return {0, UINT32_MAX}; }
+    };
+
+    /**
+     * Error codes of the non-throwing API
+     */
+    enum class Error : std::uint8_t {
+        not_found,     // key is not in the result
+        no_value,      // option was given without a value
+        out_of_range,  // index is past the end
+        unknown_id,    // id was not registered in the schema
+        invalid_utf8   // a token is not valid UTF-8
+    };
+
+    /**
+     * Describe an error code
+     * @param error : error code
+     * @return message in the style of the exceptions
+     */
+    constexpr std::string_view describe(const Error error) {
+        switch (error) {
+            case Error::not_found: return "argx:Key not found";
+            case Error::no_value: return "argx:No value";
+            case Error::out_of_range: return "argx:Index out of range";
+            case Error::unknown_id: return "argx:Unknown id";
+            case Error::invalid_utf8: return "argx:Invalid UTF-8";
+        }
+        return "argx:Unknown error";
+    }
+
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+    template <typename T, typename E>
+    using expected = std::expected<T, E>;
+    template <typename E>
+    using unexpected = std::unexpected<E>;
+#else
+    /**
+     * Error side of argx::expected, for standard libraries without std::expected
+     */
+    template <typename E>
+    class unexpected {
+    public:
+        constexpr explicit unexpected(E error): _error(std::move(error)) {}
+        [[nodiscard]] constexpr const E& error() const { return _error; }
+    private:
+        E _error;
+    };
+
+    /**
+     * Minimal std::expected for standard libraries without it
+     * Only the members used by argx are provided.
+     */
+    template <typename T, typename E>
+    class expected {
+    public:
+        constexpr expected(T value): _value(std::move(value)) {}
+        constexpr expected(unexpected<E> error): _error(error.error()) {}
+
+        [[nodiscard]] constexpr bool has_value() const { return _value.has_value(); }
+        constexpr explicit operator bool() const { return has_value(); }
+        constexpr const T& operator*() const& { return *_value; }
+        constexpr T& operator*() & { return *_value; }
+        constexpr T&& operator*() && { return std::move(*_value); }
+        constexpr const T* operator->() const { return &*_value; }
+        constexpr T* operator->() { return &*_value; }
+        [[nodiscard]] constexpr const T& value() const& {
+            if ( !has_value() ) ARGX_THROW(std::logic_error(std::string(describe(_error))));
+            return *_value;
+        }
+        [[nodiscard]] constexpr T&& value() && {
+            if ( !has_value() ) ARGX_THROW(std::logic_error(std::string(describe(_error))));
+            return std::move(*_value);
+        }
+        [[nodiscard]] constexpr const E& error() const { return _error; }
+        template <typename U>
+        [[nodiscard]] constexpr T value_or(U&& def) const& { return has_value() ? *_value : static_cast<T>(std::forward<U>(def)); }
+    private:
+        std::optional<T> _value = std::nullopt;
+        E _error = {};
+    };
+#endif
+
+    /**
+     * Flat open addressing table of key=value definitions
+     * Keys and values are views into the inserted definitions and are not
+     * copied; the parser inserts views into the token table of the result,
+     * which outlives the map. Lookups are a hash and a short linear probe.
+     */
+    class DefineMap {
+    public:
+        struct Definition {
+            std::string_view key;
+            std::string_view value;
+        };
+
+        /**
+         * Get the number of distinct keys
+         * @return number of keys
+         */
+        [[nodiscard]] size_t size() const { return _order.size(); }
+        [[nodiscard]] bool empty() const { return _order.empty(); }
+        /**
+         * Check if a key is defined
+         * @param key : key to check
+         * @return true if the key is defined
+         */
+        [[nodiscard]] bool contains(const std::string_view key) const { return find(key).has_value(); }
+        /**
+         * Get the value of a key
+         * @param key : key to look up
+         * @return value of the key, empty for "-D key" without '=', or std::nullopt if not defined
+         */
+        [[nodiscard]] std::optional<std::string_view> find(const std::string_view key) const {
+            if ( _table.empty() ) return std::nullopt;
+            const Entry& entry = _table[probe(key, hash(key))];
+            if ( !entry.used ) return std::nullopt;
+            return entry.value;
+        }
+        /**
+         * Get the value of a key or return the default value
+         * @param key : key to look up
+         * @param def : default value
+         * @return value of the key or default value
+         */
+        [[nodiscard]] std::string_view define_or_def(const std::string_view key, const std::string_view def) const {
+            return find(key).value_or(def);
+        }
+        /**
+         * Get every definition in the order keys were first defined
+         * @return list of definitions
+         */
+        [[nodiscard]] std::vector<Definition> definitions() const {
+            std::vector<Definition> result = {};
+            result.reserve(_order.size());
+            for (const auto index : _order) result.push_back({_table[index].key, _table[index].value});
+            return result;
+        }
+
+        /**
+         * Split a definition on the first '=' and store it
+         * @param definition : "key=value" or "key", must outlive the map
+         * @param duplicates : which definition wins for a repeated key
+         */
+        void insert(const std::string_view definition, const Duplicates duplicates) {
+            const size_t equals = std::min(definition.find('='), definition.size());
+            const std::string_view key = definition.substr(0, equals);
+            const std::string_view value = definition.substr(std::min(equals + 1, definition.size()));
+            if ( (_order.size() + 1) * 2 > _table.size() ) grow();
+            const size_t h = hash(key);
+            const size_t index = probe(key, h);
+            Entry& entry = _table[index];
+            if ( entry.used ) {
+                if ( duplicates == Duplicates::last_wins ) entry.value = value;
+                return;
+            }
+            entry = {key, value, static_cast<std::uint32_t>(h), true};
+            _order.push_back(static_cast<std::uint32_t>(index));
+        }
+    private:
+        struct Entry {
+            std::string_view key = {};
+            std::string_view value = {};
+            std::uint32_t hash = 0;
+            bool used = false;
+        };
+
+        static size_t hash(const std::string_view key) { return std::hash<std::string_view>{}(key); }
+        /**
+         * Index of the key, or of the empty slot where it belongs
+         */
+        [[nodiscard]] size_t probe(const std::string_view key, const size_t h) const {
+            const size_t mask = _table.size() - 1;
+            for (size_t index = h & mask;; index = (index + 1) & mask) {
+                const Entry& entry = _table[index];
+                if ( !entry.used ) return index;
+                if ( entry.hash == static_cast<std::uint32_t>(h) && entry.key == key ) return index;
+            }
+        }
+        void grow() {
+            std::vector<Entry> old = std::exchange(_table, std::vector<Entry>(std::max<size_t>(16, _table.size() * 2)));
+            const size_t mask = _table.size() - 1;
+            for (auto& index : _order) {
+                const Entry& entry = old[index];
+                size_t slot = entry.hash & mask;
+                while ( _table[slot].used ) slot = (slot + 1) & mask;
+                _table[slot] = entry;
+                index = static_cast<std::uint32_t>(slot);
+            }
+        }
+
+        std::vector<Entry> _table;
+        std::vector<std::uint32_t> _order; // table indices in first definition order
+    };
+
+    namespace detail {
+        struct string_hash {
+            using is_transparent = void;
+            size_t operator()(const std::string_view text) const { return std::hash<std::string_view>{}(text); }
+        };
+        typedef std::unordered_map<std::string, option_id, string_hash, std::equal_to<>> alias_map;
+
+        struct slot {
+            std::uint32_t count = 0;          // occurrences
+            std::uint32_t entry = UINT32_MAX; // number in the option table, once present
+            std::uint32_t kept = UINT32_MAX;  // token holding the value of a Storage::last option while parsing
+            DefineMap defines = {};           // map options only
+        };
+
+        struct Collector;
+
+        inline void set_bit(std::vector<std::uint64_t>& bits, const size_t index) {
+            if ( bits.size() <= index / 64 ) bits.resize(index / 64 + 1, 0);
+            bits[index / 64] |= std::uint64_t(1) << (index % 64);
+        }
+        inline std::uint64_t word(const std::vector<std::uint64_t>& bits, const size_t index) {
+            return index < bits.size() ? bits[index] : 0;
+        }
+    }
+
+    class ParseResult;
+
+    namespace detail {
+        /**
+         * Count a byte in a buffer, 16 bytes per step where SIMD is available
+         */
+        inline size_t count_byte(const char* data, const size_t size, const char c) {
+            size_t count = 0;
+            size_t i = 0;
+#if defined(__SSE2__)
+            const __m128i needle = _mm_set1_epi8(c);
+            for (; i + 16 <= size; i += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                count += std::popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle))));
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__) // vaddvq_u8 is AArch64 only
+            const uint8x16_t needle = vdupq_n_u8(static_cast<std::uint8_t>(c));
+            for (; i + 16 <= size; i += 16) {
+                const uint8x16_t hits = vceqq_u8(vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + i)), needle);
+                count += vaddvq_u8(vshrq_n_u8(hits, 7));
+            }
+#endif
+            for (; i < size; i++) count += data[i] == c;
+            return count;
+        }
+    }
+
+    /**
+     * Convert a delimited list of numbers straight into a typed vector
+     * Example: "1,2,3" -> {1, 2, 3}
+     * @param text : delimited numbers
+     * @param delimiter : separator between numbers
+     * @return numbers in order, empty if text is empty
+     * @throw std::invalid_argument if an element is not a number of type T
+     */
+    template <typename T> requires std::integral<T> || std::floating_point<T>
+    std::vector<T> parse_list(const std::string_view text, const char delimiter = ',') {
+        std::vector<T> result = {};
+        if ( text.empty() ) return result;
+        result.reserve(detail::count_byte(text.data(), text.size(), delimiter) + 1);
+        const char* cursor = text.data();
+        const char* const end = text.data() + text.size();
+        while ( true ) {
+            T value = {};
+            const auto [next, error] = std::from_chars(cursor, end, value);
+            if ( error != std::errc() || (next != end && *next != delimiter) )
+                ARGX_THROW(std::invalid_argument("argx:parse_list:Invalid number at:"+std::to_string(cursor - text.data())));
+            result.push_back(value);
+            if ( next == end ) break;
+            cursor = next + 1;
+        }
+        return result;
+    }
+
+    /**
+     * Constraint of a Schema that a result does not satisfy
+     */
+    struct Violation {
+        enum class Kind {
+            missing,         // required option is absent
+            conflict,        // id and other are mutually exclusive
+            implied_missing, // id implies other, which is absent
+            out_of_range,    // value of id is not a number within the range
+            not_allowed,     // value of id is not in the allowed set
+            wrong_arity      // an occurrence of id has too few values
+        };
+        Kind kind;
+        option_id id;
+        option_id other;
+        std::string_view value; // offending value, points into the result
+    };
+
+    /**
+     * Id of a key interned in a argx::KeyPool
+     */
+    enum class key_id : std::uint32_t {};
+
+    /**
+     * Pool of interned option keys, shared by many results
+     * Every distinct key is stored once and gets a stable id and view.
+     * Lookups never lock: names live in chunks that never move and are published
+     * through an atomic size, so parsers running in parallel can share the pool.
+     * Only intern() of a new key takes the writer lock.
+     */
+    class KeyPool {
+    public:
+        KeyPool() = default;
+        KeyPool(const KeyPool&) = delete;
+        KeyPool& operator=(const KeyPool&) = delete;
+        ~KeyPool() {
+            for ( auto& chunk : _chunks ) delete[] chunk.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Intern a key
+         * @param key : key to intern
+         * @return id of the key, the same for every call with an equal key
+         */
+        key_id intern(const std::string_view key) {
+            if ( const auto id = find(key) ) return *id;
+            std::lock_guard lock(_mutex);
+            if ( const auto id = find(key) ) return *id;
+            const std::uint32_t index = _size.load(std::memory_order_relaxed);
+            const std::uint32_t chunk = chunk_of(index);
+            if ( chunk >= _chunks.size() ) ARGX_THROW(std::length_error("argx:KeyPool:Too many keys"));
+            Name* names = _chunks[chunk].load(std::memory_order_relaxed);
+            if ( names == nullptr ) {
+                names = new Name[chunk_size << chunk];
+                _chunks[chunk].store(names, std::memory_order_release);
+            }
+            names[index - chunk_start(chunk)] = Name{store(key), static_cast<std::uint32_t>(key.size()), hash(key)};
+            if ( _table == nullptr || (static_cast<size_t>(index) + 1) * 2 > _table->mask + 1 ) rehash(index);
+            // The size is published before the slot, so an id found through the table is always in range
+            _size.store(index + 1, std::memory_order_release);
+            insert(*_table, index);
+            return static_cast<key_id>(index);
+        }
+        /**
+         * Find an interned key without adding it
+         * @param key : key to find
+         * @return id of the key or std::nullopt
+         */
+        [[nodiscard]] std::optional<key_id> find(const std::string_view key) const {
+            const Table* table = _current.load(std::memory_order_acquire);
+            if ( table == nullptr ) return std::nullopt;
+            const std::uint32_t code = hash(key);
+            for ( size_t i = code & table->mask;; i = (i + 1) & table->mask ) {
+                const std::uint32_t slot = table->slots[i].load(std::memory_order_acquire);
+                if ( slot == 0 ) return std::nullopt;
+                const Name& name = at(slot - 1);
+                if ( name.hash == code && std::string_view(name.data, name.length) == key ) return static_cast<key_id>(slot - 1);
+            }
+        }
+        /**
+         * Get an interned key
+         * @param id : id of the key
+         * @return key, valid as long as the pool
+         * @throw std::out_of_range if id was not interned in this pool
+         */
+        [[nodiscard]] std::string_view name(const key_id id) const {
+            const auto index = static_cast<std::uint32_t>(id);
+            if ( index >= _size.load(std::memory_order_acquire) ) ARGX_THROW(std::out_of_range("argx:KeyPool:Unknown id:"+std::to_string(index)));
+            const Name& name = at(index);
+            return {name.data, name.length};
+        }
+        /**
+         * Get the number of interned keys
+         * @return number of keys
+         */
+        [[nodiscard]] size_t size() const {
+            return _size.load(std::memory_order_acquire);
+        }
+    private:
+        struct Name {
+            const char* data = nullptr;
+            std::uint32_t length = 0;
+            std::uint32_t hash = 0;
+        };
+        // Open addressing over ids + 1, 0 marks an empty slot
+        struct Table {
+            explicit Table(const size_t capacity) : mask(capacity - 1), slots(new std::atomic<std::uint32_t>[capacity]()) {}
+            size_t mask;
+            std::unique_ptr<std::atomic<std::uint32_t>[]> slots;
+        };
+
+        static constexpr std::uint32_t chunk_size = 64; // chunk c holds chunk_size << c names
+
+        [[nodiscard]] static std::uint32_t hash(const std::string_view key) {
+            return static_cast<std::uint32_t>(std::hash<std::string_view>{}(key));
+        }
+        [[nodiscard]] static std::uint32_t chunk_of(const std::uint32_t index) {
+            return static_cast<std::uint32_t>(std::bit_width(index / chunk_size + 1)) - 1;
+        }
+        [[nodiscard]] static std::uint32_t chunk_start(const std::uint32_t chunk) {
+            return chunk_size * ((std::uint32_t{1} << chunk) - 1);
+        }
+        [[nodiscard]] const Name& at(const std::uint32_t index) const {
+            const std::uint32_t chunk = chunk_of(index);
+            return _chunks[chunk].load(std::memory_order_acquire)[index - chunk_start(chunk)];
+        }
+        const char* store(const std::string_view key) {
+            if ( key.size() > _left ) {
+                _blocks.push_back(std::make_unique<char[]>(std::max<size_t>(key.size(), 4096)));
+                _cursor = _blocks.back().get();
+                _left = std::max<size_t>(key.size(), 4096);
+            }
+            if ( !key.empty() ) std::memcpy(_cursor, key.data(), key.size());
+            const char* stored = _cursor;
+            _cursor += key.size();
+            _left -= key.size();
+            return stored;
+        }
+        void insert(const Table& table, const std::uint32_t index) const {
+            size_t i = at(index).hash & table.mask;
+            while ( table.slots[i].load(std::memory_order_relaxed) != 0 ) i = (i + 1) & table.mask;
+            table.slots[i].store(index + 1, std::memory_order_release);
+        }
+        // Readers may still probe a replaced table, so it stays alive with the pool
+        void rehash(const std::uint32_t count) {
+            auto& table = _tables.emplace_back(std::make_unique<Table>(std::max<size_t>(64, std::bit_ceil(static_cast<size_t>(count) * 4))));
+            for ( std::uint32_t i = 0; i < count; ++i ) insert(*table, i);
+            _table = table.get();
+            _current.store(_table, std::memory_order_release);
+        }
+
+        std::array<std::atomic<Name*>, 26> _chunks{};
+        std::atomic<std::uint32_t> _size{0};
+        std::atomic<const Table*> _current{nullptr};
+        // Writer state, guarded by _mutex
+        std::mutex _mutex;
+        Table* _table = nullptr;
+        std::vector<std::unique_ptr<Table>> _tables;
+        std::vector<std::unique_ptr<char[]>> _blocks;
+        char* _cursor = nullptr;
+        size_t _left = 0;
+    };
+
+    /**
+     * Table of known options and flags
+     * Every alias maps to one canonical id, so results parsed with the schema
+     * store all aliases of an option in a single slot. The schema must outlive
+     * the results parsed with it.
+     */
+    class Schema {
+    public:
+        /**
+         * Register an option (-key) under one or more aliases
+         * @param aliases : aliases of the option, the first one is the canonical name
+         * @return id of the option
+         * @throw std::invalid_argument if no alias is given or an alias is already registered or repeated
+         */
+        option_id add(const string_il aliases) { return insert(aliases, false); }
+        /**
+         * Register a flag (--key) under one or more aliases
+         * @param aliases : aliases of the flag, the first one is the canonical name
+         * @return id of the flag
+         * @throw std::invalid_argument if no alias is given or an alias is already registered or repeated
+         */
+        option_id add_flag(const string_il aliases) { return insert(aliases, true); }
+        /**
+         * Register an option (-key) under aliases known only at runtime
+         * @param aliases : aliases of the option, the first one is the canonical name
+         * @return id of the option
+         * @throw std::invalid_argument if no alias is given or an alias is already registered or repeated
+         */
+        option_id add(const std::span<const std::string> aliases) { return insert(aliases, false); }
+        /**
+         * Register a flag (--key) under aliases known only at runtime
+         * @param aliases : aliases of the flag, the first one is the canonical name
+         * @return id of the flag
+         * @throw std::invalid_argument if no alias is given or an alias is already registered or repeated
+         */
+        option_id add_flag(const std::span<const std::string> aliases) { return insert(aliases, true); }
+
+        /**
+         * Require an option or flag to be present
+         * @param id : id of the option or flag
+         * @return this schema
+         */
+        Schema& require(const option_id id) {
+            detail::set_bit(_required, index(id));
+            return *this;
+        }
+        /**
+         * Make options or flags mutually exclusive
+         * @param ids : ids of which at most one may be present
+         * @return this schema
+         * @throw std::out_of_range if an id was not registered
+         */
+        Schema& conflicts(const std::initializer_list<option_id> ids) {
+            for (const auto id : ids) static_cast<void>(index(id)); // Check every id before any bit is set
+            for (const auto id : ids)
+                for (const auto other : ids)
+                    if ( id != other ) detail::set_bit(rules(id).conflicts, static_cast<size_t>(other));
+            return *this;
+        }
+        /**
+         * Make one option or flag require another
+         * @param id : id that implies the other one
+         * @param implied : id that must be present whenever id is present
+         * @return this schema
+         */
+        Schema& implies(const option_id id, const option_id implied) {
+            detail::set_bit(rules(id).implies, index(implied));
+            return *this;
+        }
+        /**
+         * Restrict every value of an option to a numeric range
+         * @param id : id of the option
+         * @param min : smallest allowed value
+         * @param max : largest allowed value
+         * @return this schema
+         */
+        Schema& range(const option_id id, const double min, const double max) {
+            auto& entry = rules(id);
+            entry.ranged = true;
+            entry.min = min;
+            entry.max = max;
+            return *this;
+        }
+        /**
+         * Restrict every value of an option to a set of values
+         * @param id : id of the option
+         * @param values : allowed values
+         * @return this schema
+         */
+        Schema& allow(const option_id id, const string_il values) {
+            auto& entry = rules(id);
+            entry.allowed.insert(entry.allowed.end(), values.begin(), values.end());
+            return *this;
+        }
+
+        /**
+         * Check every constraint without allocating
+         * @param result : result parsed with this schema
+         * @return true if all constraints hold
+         * @throw std::invalid_argument if the result was parsed with another schema
+         */
+        [[nodiscard]] bool valid(const ParseResult& result) const {
+            return check(result, [](const Violation&) { return false; });
+        }
+        /**
+         * Collect every violated constraint
+         * @param result : result parsed with this schema
+         * @return list of violations, empty if all constraints hold
+         * @throw std::invalid_argument if the result was parsed with another schema
+         */
+        [[nodiscard]] std::vector<Violation> violations(const ParseResult& result) const {
+            std::vector<Violation> found = {};
+            check(result, [&](const Violation& violation) { found.push_back(violation); return true; });
+            return found;
+        }
+        /**
+         * Check every constraint and throw on the first violation
+         * @param result : result parsed with this schema
+         * @throw std::invalid_argument describing the first violation
+         */
+        void validate(const ParseResult& result) const {
+            std::optional<Violation> first = std::nullopt;
+            check(result, [&](const Violation& violation) { first = violation; return false; });
+            if ( first.has_value() ) ARGX_THROW(std::invalid_argument(describe(*first)));
+        }
+        /**
+         * Describe a violation
+         * @param violation : violation found in a result parsed with this schema
+         * @return human readable message
+         */
+        [[nodiscard]] std::string describe(const Violation& violation) const {
+            switch (violation.kind) {
+                case Violation::Kind::missing:
+                    return "argx:Schema:Missing required:"+name(violation.id);
+                case Violation::Kind::conflict:
+                    return "argx:Schema:Conflicting:"+name(violation.id)+","+name(violation.other);
+                case Violation::Kind::implied_missing:
+                    return "argx:Schema:Missing implied:"+name(violation.id)+","+name(violation.other);
+                case Violation::Kind::out_of_range:
+                    return "argx:Schema:Value out of range:"+name(violation.id)+"="+std::string(violation.value);
+                case Violation::Kind::not_allowed:
+                    return "argx:Schema:Value not allowed:"+name(violation.id)+"="+std::string(violation.value);
+                case Violation::Kind::wrong_arity:
+                    return "argx:Schema:Wrong number of values:"+name(violation.id);
+            }
+            return "argx:Schema:Unknown violation";
+        }
+
+        /**
+         * Get the number of registered options and flags
+         * @return number of ids
+         */
+        [[nodiscard]] size_t size() const { return _entries.size(); }
+        /**
+         * Find the id of an option alias
+         * @param alias : alias of the option
+         * @return id of the option or std::nullopt
+         */
+        [[nodiscard]] std::optional<option_id> find(const std::string_view alias) const {
+            const auto it = _options.find(alias);
+            if ( it == _options.end() ) return std::nullopt;
+            return it->second;
+        }
+        /**
+         * Find the id of a flag alias
+         * @param alias : alias of the flag
+         * @return id of the flag or std::nullopt
+         */
+        [[nodiscard]] std::optional<option_id> find_flag(const std::string_view alias) const {
+            const auto it = _flags.find(alias);
+            if ( it == _flags.end() ) return std::nullopt;
+            return it->second;
+        }
+        /**
+         * Get the canonical name of an id
+         * @param id : id of the option or flag
+         * @return first registered alias
+         */
+        [[nodiscard]] const std::string& name(const option_id id) const { return entry(id).aliases.front(); }
+        /**
+         * Get all aliases of an id
+         * @param id : id of the option or flag
+         * @return aliases in registration order
+         */
+        [[nodiscard]] const std::vector<std::string>& aliases(const option_id id) const { return entry(id).aliases; }
+        /**
+         * Check if an id was registered as a flag
+         * @param id : id of the option or flag
+         * @return true for flags, false for options
+         */
+        [[nodiscard]] bool is_flag(const option_id id) const { return entry(id).flag; }
+        /**
+         * Set the help text of an option or flag
+         * @param id : id of the option or flag
+         * @param text : description shown by argx::Help
+         * @param value_name : name of the value shown after an option, e.g. "N"
+         * @return this schema
+         */
+        Schema& help(const option_id id, std::string text, std::string value_name = {}) {
+            auto& entry = _entries[index(id)];
+            entry.help = std::move(text);
+            entry.value_name = std::move(value_name);
+            _revision++;
+            return *this;
+        }
+        /**
+         * Get the help text of an option or flag
+         * @param id : id of the option or flag
+         * @return help text, empty if none was set
+         */
+        [[nodiscard]] const std::string& help(const option_id id) const { return entry(id).help; }
+        /**
+         * Get the value name of an option
+         * @param id : id of the option
+         * @return value name, empty if none was set
+         */
+        [[nodiscard]] const std::string& value_name(const option_id id) const { return entry(id).value_name; }
+        /**
+         * Get the revision of the names and help texts
+         * Every add and help call increases it, so cached help text can tell it is stale.
+         * @return revision
+         */
+        [[nodiscard]] std::uint64_t revision() const { return _revision; }
+        /**
+         * Make an option a map option, every value is split on the first '='
+         * Example: -D name=value -D other=1
+         * @param id : id of the option
+         * @param duplicates : which definition wins for a repeated key
+         * @return this schema
+         */
+        Schema& map(const option_id id, const Duplicates duplicates = Duplicates::last_wins) {
+            auto& entry = _entries[index(id)];
+            entry.map = true;
+            entry.duplicates = duplicates;
+            return *this;
+        }
+        /**
+         * Check if an option is a map option
+         * @param id : id of the option
+         * @return true for map options
+         */
+        [[nodiscard]] bool is_map(const option_id id) const { return entry(id).map; }
+        /**
+         * Get the duplicate handling of a map option
+         * @param id : id of the option
+         * @return which definition wins for a repeated key
+         */
+        [[nodiscard]] Duplicates duplicates(const option_id id) const { return entry(id).duplicates; }
+        /**
+         * Choose how an option keeps repeated occurrences
+         * Example: -v -v -v with Storage::count
+         * @param id : id of the option
+         * @param storage : storage policy
+         * @return this schema
+         */
+        Schema& store(const option_id id, const Storage storage) {
+            _entries[index(id)].storage = storage;
+            return *this;
+        }
+        /**
+         * Get the storage policy of an option
+         * @param id : id of the option
+         * @return storage policy
+         */
+        [[nodiscard]] Storage storage(const option_id id) const { return entry(id).storage; }
+        /**
+         * Let an option take several values per occurrence
+         * Example: -bbox x0 y0 x1 y1 with Arity::exactly(4)
+         * ParseResult::values splits the values by occurrence, options() lists
+         * them all. An occurrence with fewer than arity.min values is reported as a violation.
+         * @param id : id of the option
+         * @param arity : number of values per occurrence
+         * @return this schema
+         */
+        Schema& nargs(const option_id id, const Arity arity) {
+            if ( arity.min > arity.max ) ARGX_THROW(std::invalid_argument("argx:Schema:Invalid arity"));
+            rules(id).arity = arity;
+            return *this;
+        }
+        /**
+         * Get the arity of an option
+         * @param id : id of the option
+         * @return arity, std::nullopt for options with a single value
+         */
+        [[nodiscard]] std::optional<Arity> arity(const option_id id) const { return entry(id).arity; }
+        /**
+         * Require every token to be valid UTF-8
+         * @param required : true to validate tokens in argx::parse
+         * @return this schema
+         */
+        Schema& utf8(const bool required = true) {
+            _utf8 = required;
+            return *this;
+        }
+        /**
+         * Check if tokens must be valid UTF-8
+         * @return true if argx::parse validates tokens
+         */
+        [[nodiscard]] bool utf8() const { return _utf8; }
+        /**
+         * Intern the keys of unregistered options in a shared pool
+         * Results parsed with this schema then store key ids instead of key copies.
+         * @param pool : key pool, must outlive the results
+         * @return this schema
+         */
+        Schema& intern(KeyPool& pool) {
+            _pool = &pool;
+            return *this;
+        }
+        /**
+         * Get the key pool of the schema
+         * @return key pool or nullptr
+         */
+        [[nodiscard]] KeyPool* pool() const { return _pool; }
+    private:
+        struct Entry {
+            std::vector<std::string> aliases;
+            bool flag;
+            std::string help = {};
+            std::string value_name = {};
+            bool map = false;
+            Duplicates duplicates = Duplicates::last_wins;
+            Storage storage = Storage::append;
+            std::optional<Arity> arity = std::nullopt;
+            std::vector<std::uint64_t> conflicts = {};
+            std::vector<std::uint64_t> implies = {};
+            bool ranged = false;
+            double min = 0;
+            double max = 0;
+            std::vector<std::string> allowed = {};
+        };
+
+        Entry& rules(const option_id id) {
+            detail::set_bit(_ruled, index(id));
+            return _entries[index(id)];
+        }
+        template <typename F>
+        bool check(const ParseResult& result, F&& report) const;
+
+        template <typename R>
+        option_id insert(const R& aliases, const bool flag) {
+            if ( std::ranges::empty(aliases) ) ARGX_THROW(std::invalid_argument("argx:Schema:No alias given"));
+            auto& table = flag ? _flags : _options;
+            for (auto it = std::ranges::begin(aliases); it != std::ranges::end(aliases); ++it)
+                if ( table.contains(*it) || std::find(std::ranges::begin(aliases), it, *it) != it )
+                    ARGX_THROW(std::invalid_argument("argx:Schema:Duplicate alias:"+std::string(*it)));
+            const auto id = static_cast<option_id>(_entries.size());
+            for (const auto& alias : aliases)
+                table.emplace(alias, id);
+            _entries.push_back({std::vector<std::string>(std::ranges::begin(aliases), std::ranges::end(aliases)), flag});
+            _revision++;
+            return id;
+        }
+        size_t index(const option_id id) const {
+            const auto index = static_cast<size_t>(id);
+            if ( index >= _entries.size() ) ARGX_THROW(std::out_of_range("argx:Schema:Unknown id:"+std::to_string(index)));
+            return index;
+        }
+        [[nodiscard]] const Entry& entry(const option_id id) const { return _entries[index(id)]; }
+
+        std::vector<Entry> _entries;
+        std::vector<std::uint64_t> _required;
+        std::vector<std::uint64_t> _ruled; // ids with conflicts, implies or value rules
+        bool _utf8 = false;
+        std::uint64_t _revision = 0; // names and help texts
+        KeyPool* _pool = nullptr;
+        detail::alias_map _options;
+        detail::alias_map _flags;
+    };
+
+    /**
+     * Compact range expression such as "rack[1-40]-node[001-128]"
+     * Brackets hold comma separated numbers or ranges, a leading zero pads
+     * to the width of the first bound, and top level commas separate
+     * independent patterns. Names are produced on demand, so the expression
+     * can be sharded by index without materializing every name.
+     */
+    class RangeExpr {
+    public:
+        class iterator {
+        public:
+            // names are produced on dereference, so for C++17 algorithms this is only an input iterator
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::string;
+            using difference_type = std::int64_t;
+            using pointer = void;
+            using reference = std::string;
+
+            iterator() = default;
+            iterator(const RangeExpr* expr, const std::uint64_t index): _expr(expr), _index(index) {}
+
+            std::string operator*() const { return _expr->nth(_index); }
+            std::string operator[](const difference_type n) const { return _expr->nth(_index + n); }
+            iterator& operator++() { ++_index; return *this; }
+            iterator operator++(int) { auto it = *this; ++_index; return it; }
+            iterator& operator--() { --_index; return *this; }
+            iterator operator--(int) { auto it = *this; --_index; return it; }
+            iterator& operator+=(const difference_type n) { _index += n; return *this; }
+            iterator& operator-=(const difference_type n) { _index -= n; return *this; }
+            friend iterator operator+(iterator it, const difference_type n) { return it += n; }
+            friend iterator operator+(const difference_type n, iterator it) { return it += n; }
+            friend iterator operator-(iterator it, const difference_type n) { return it -= n; }
+            friend difference_type operator-(const iterator& a, const iterator& b) {
+                return static_cast<difference_type>(a._index - b._index);
+            }
+            bool operator==(const iterator& other) const { return _index == other._index; }
+            auto operator<=>(const iterator& other) const { return _index <=> other._index; }
+        private:
+            const RangeExpr* _expr = nullptr;
+            std::uint64_t _index = 0;
+        };
+
+        RangeExpr() = default;
+        /**
+         * Parse a range expression
+         * @param pattern : expression, e.g. "node[1-4,8],login[01-02]"
+         * @throw std::invalid_argument if the expression is malformed or too large
+         */
+        explicit RangeExpr(const std::string_view pattern): _text(pattern) {
+            const auto fail = [&] { ARGX_THROW(std::invalid_argument("argx:RangeExpr:Malformed range:"+_text)); };
+            size_t i = 0;
+            while ( i <= _text.size() ) {
+                Term term = {static_cast<std::uint32_t>(_groups.size()), 0, 0, 0, 1};
+                size_t literal = i;
+                while ( i < _text.size() && _text[i] != ',' ) {
+                    if ( _text[i] == ']' ) fail();
+                    if ( _text[i] != '[' ) { i++; continue; }
+                    Group group = {static_cast<std::uint32_t>(literal), static_cast<std::uint32_t>(i - literal),
+                                   static_cast<std::uint32_t>(_intervals.size()), 0, 0, 1};
+                    i++;
+                    while ( true ) {
+                        const auto number = [&](std::uint64_t& value) {
+                            const size_t start = i;
+                            while ( i < _text.size() && _text[i] >= '0' && _text[i] <= '9' ) i++;
+                            const auto [end, error] = std::from_chars(_text.data() + start, _text.data() + i, value);
+                            if ( i == start || error != std::errc() ) fail();
+                            return i - start;
+                        };
+                        Interval interval = {};
+                        const size_t start = i;
+                        const size_t digits = number(interval.first);
+                        interval.last = interval.first;
+                        interval.width = digits > 1 && _text[start] == '0' ? digits : 0;
+                        if ( i < _text.size() && _text[i] == '-' ) {
+                            i++;
+                            number(interval.last);
+                            if ( interval.last < interval.first ) fail();
+                        }
+                        group.size = checked_add(group.size, checked_add(interval.last - interval.first, 1));
+                        _intervals.push_back(interval);
+                        group.interval_count++;
+                        if ( i < _text.size() && _text[i] == ',' ) { i++; continue; }
+                        if ( i < _text.size() && _text[i] == ']' ) { i++; break; }
+                        fail();
+                    }
+                    _groups.push_back(group);
+                    term.group_count++;
+                    literal = i;
+                }
+                term.tail_offset = literal;
+                term.tail_length = i - literal;
+                if ( term.group_count != 0 || term.tail_length != 0 ) {
+                    std::uint64_t stride = 1;
+                    for (size_t g = term.first_group + term.group_count; g-- > term.first_group;) {
+                        _groups[g].stride = stride;
+                        stride = checked_mul(stride, _groups[g].size);
+                    }
+                    term.size = stride;
+                    _size = checked_add(_size, term.size);
+                    _terms.push_back(term);
+                } else {
+                    _groups.resize(term.first_group);
+                }
+                i++; // Skip the comma
+            }
+        }
+
+        /**
+         * Get the number of names
+         * @return number of names
+         */
+        [[nodiscard]] std::uint64_t size() const { return _size; }
+        [[nodiscard]] bool empty() const { return _size == 0; }
+        /**
+         * Get the expression as given
+         * @return expression
+         */
+        [[nodiscard]] const std::string& pattern() const { return _text; }
+
+        /**
+         * Write the name at the index into a buffer
+         * @param index : index of the name
+         * @param out : buffer, replaced by the name
+         * @throw std::out_of_range if index is out of range
+         */
+        void nth(std::uint64_t index, std::string& out) const {
+            if ( index >= _size ) ARGX_THROW(std::out_of_range("argx:RangeExpr:Index out of range:"+std::to_string(index)));
+            out.clear();
+            const Term* term = _terms.data();
+            while ( index >= term->size ) index -= term++->size;
+            for (size_t g = term->first_group; g < term->first_group + term->group_count; g++) {
+                const Group& group = _groups[g];
+                out.append(_text, group.literal_offset, group.literal_length);
+                std::uint64_t digit = index / group.stride % group.size;
+                for (size_t k = group.first_interval;; k++) {
+                    const Interval& interval = _intervals[k];
+                    const std::uint64_t count = interval.last - interval.first + 1;
+                    if ( digit >= count ) { digit -= count; continue; }
+                    char buffer[24];
+                    const auto end = std::to_chars(buffer, buffer + sizeof(buffer), interval.first + digit).ptr;
+                    const size_t length = end - buffer;
+                    if ( interval.width > length ) out.append(interval.width - length, '0');
+                    out.append(buffer, length);
+                    break;
+                }
+            }
+            out.append(_text, term->tail_offset, term->tail_length);
+        }
+        /**
+         * Get the name at the index
+         * @param index : index of the name
+         * @return name
+         * @throw std::out_of_range if index is out of range
+         */
+        [[nodiscard]] std::string nth(const std::uint64_t index) const {
+            std::string out = {};
+            nth(index, out);
+            return out;
+        }
+        /**
+         * Check if a name is produced by the expression, without enumerating it
+         * @param name : name to check
+         * @return true if the name is part of the expression
+         */
+        [[nodiscard]] bool contains(const std::string_view name) const {
+            for (const auto& term : _terms)
+                if ( match(term, term.first_group, name) ) return true;
+            return false;
+        }
+
+        [[nodiscard]] iterator begin() const { return {this, 0}; }
+        [[nodiscard]] iterator end() const { return {this, _size}; }
+    private:
+        struct Interval {
+            std::uint64_t first;
+            std::uint64_t last;
+            size_t width; // zero padded width, 0 when not padded
+        };
+        struct Group {
+            std::uint32_t literal_offset; // text before the brackets
+            std::uint32_t literal_length;
+            std::uint32_t first_interval;
+            std::uint32_t interval_count;
+            std::uint64_t size;
+            std::uint64_t stride; // number of names per step of this group
+        };
+        struct Term {
+            std::uint32_t first_group;
+            std::uint32_t group_count;
+            std::uint32_t tail_offset; // text after the last brackets
+            std::uint32_t tail_length;
+            std::uint64_t size;
+        };
+
+        std::uint64_t checked_add(const std::uint64_t a, const std::uint64_t b) const {
+            if ( a > UINT64_MAX - b ) ARGX_THROW(std::invalid_argument("argx:RangeExpr:Range too large:"+_text));
+            return a + b;
+        }
+        std::uint64_t checked_mul(const std::uint64_t a, const std::uint64_t b) const {
+            if ( a != 0 && b > UINT64_MAX / a ) ARGX_THROW(std::invalid_argument("argx:RangeExpr:Range too large:"+_text));
+            return a * b;
+        }
+        bool match(const Term& term, const size_t g, std::string_view rest) const {
+            if ( g == term.first_group + term.group_count )
+                return rest == std::string_view(_text).substr(term.tail_offset, term.tail_length);
+            const Group& group = _groups[g];
+            const std::string_view literal = std::string_view(_text).substr(group.literal_offset, group.literal_length);
+            if ( !rest.starts_with(literal) ) return false;
+            rest.remove_prefix(literal.size());
+            size_t digits = 0;
+            while ( digits < rest.size() && digits < 20 && rest[digits] >= '0' && rest[digits] <= '9' ) digits++;
+            for (size_t length = 1; length <= digits; length++) {
+                std::uint64_t value = 0;
+                if ( std::from_chars(rest.data(), rest.data() + length, value).ec != std::errc() ) break;
+                char buffer[24];
+                const size_t natural = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr - buffer;
+                for (size_t k = group.first_interval; k < group.first_interval + group.interval_count; k++) {
+                    const Interval& interval = _intervals[k];
+                    if ( value < interval.first || value > interval.last || length != std::max(interval.width, natural) ) continue;
+                    if ( match(term, g + 1, rest.substr(length)) ) return true;
+                    break;
+                }
+            }
+            return false;
+        }
+
+        std::string _text;
+        std::vector<Interval> _intervals;
+        std::vector<Group> _groups;
+        std::vector<Term> _terms;
+        std::uint64_t _size = 0;
+    };
+
+    /**
+     * Role of a command line token
+     * value is an argument bound to the option before it
+     */
+    enum class TokenKind : std::uint8_t { argument, option, flag, value };
+
+    /**
+     * One command line token, as given
+     * key is the option or flag name without dashes (for values, the option
+     * they belong to), value is the text of arguments and values.
+     */
+    struct Token {
+        TokenKind kind;
+        std::string_view key;
+        std::string_view value;
+        std::uint32_t index; // position in argv
+    };
+
+    namespace detail {
+        /**
+         * Tokens of one parse in command line order, as parallel arrays
+         * The columns share one allocation: six uint32_t columns followed by one
+         * kind byte per token. Every text lives in one byte buffer
+         * and is referenced by offset and length. This table is the only copy
+         * of the parsed text, results hold views into it. With a key pool, the
+         * keys of unregistered options are pool ids and are not copied.
+         */
+        struct token_table {
+            enum column : size_t { key_offsets, key_lengths, value_offsets, value_lengths, indices, owners, column_count };
+
+            std::vector<std::uint32_t> columns = {}; // column c of token i at c * capacity + i, then the kinds
+            std::string bytes = {};
+            const KeyPool* pool = nullptr;           // resolves keys stored as ids
+            static constexpr std::uint32_t interned = UINT32_MAX; // key length of a key stored as a pool id
+            size_t count = 0;
+            size_t capacity = 0;
+
+            void reserve(const size_t tokens, const size_t size) {
+                if ( tokens > capacity ) {
+                    std::vector<std::uint32_t> grown(tokens * column_count + (tokens + 3) / 4);
+                    for (size_t c = 0; c < column_count; c++)
+                        std::copy_n(columns.begin() + c * capacity, count, grown.begin() + c * tokens);
+                    if ( count != 0 ) std::memcpy(grown.data() + tokens * column_count, kind_bytes(), count);
+                    columns = std::move(grown);
+                    capacity = tokens;
+                }
+                bytes.reserve(size);
+            }
+            [[nodiscard]] size_t size() const { return count; }
+            std::uint32_t append(const std::string_view text) {
+                const auto offset = static_cast<std::uint32_t>(bytes.size());
+                bytes.append(text);
+                return offset;
+            }
+            /**
+             * Append a token
+             * owner is the option entry of options and values, the id of registered flags,
+             * UINT32_MAX otherwise.
+             */
+            void push(const TokenKind kind, const std::uint32_t key_offset, const std::uint32_t key_length,
+                      const std::uint32_t value_offset, const std::uint32_t value_length, const std::uint32_t index,
+                      const std::uint32_t owner) {
+                if ( count == capacity ) reserve(std::max<size_t>(16, capacity * 2), 0);
+                const std::uint32_t row[column_count] = {key_offset, key_length, value_offset, value_length, index, owner};
+                for (size_t c = 0; c < column_count; c++) columns[c * capacity + count] = row[c];
+                kind_bytes()[count] = static_cast<std::uint8_t>(kind);
+                count++;
+            }
+            [[nodiscard]] std::uint32_t at(const column c, const size_t i) const { return columns[c * capacity + i]; }
+            void set(const column c, const size_t i, const std::uint32_t value) { columns[c * capacity + i] = value; }
+            [[nodiscard]] TokenKind kind(const size_t i) const { return static_cast<TokenKind>(kind_bytes()[i]); }
+            [[nodiscard]] std::string_view key(const size_t i) const {
+                if ( at(key_lengths, i) == interned ) return pool->name(static_cast<key_id>(at(key_offsets, i)));
+                return {bytes.data() + at(key_offsets, i), at(key_lengths, i)};
+            }
+            [[nodiscard]] std::string_view value(const size_t i) const { return {bytes.data() + at(value_offsets, i), at(value_lengths, i)}; }
+            [[nodiscard]] Token operator[](const size_t i) const { return {kind(i), key(i), value(i), at(indices, i)}; }
+        private:
+            // Kinds are bytes after the last column, unsigned char may alias the uint32_t storage
+            [[nodiscard]] std::uint8_t* kind_bytes() { return reinterpret_cast<std::uint8_t*>(columns.data() + column_count * capacity); }
+            [[nodiscard]] const std::uint8_t* kind_bytes() const {
+                return reinterpret_cast<const std::uint8_t*>(columns.data() + column_count * capacity);
+            }
+        };
+    }
+
+    /**
+     * Tokens of a result in command line order
+     */
+    class TokenRange {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Token;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Token;
+
+            iterator() = default;
+            iterator(const detail::token_table* table, const size_t index): _table(table), _index(index) {}
+
+            Token operator*() const { return (*_table)[_index]; }
+            iterator& operator++() { ++_index; return *this; }
+            iterator operator++(int) { auto it = *this; ++_index; return it; }
+            bool operator==(const iterator& other) const { return _index == other._index; }
+        private:
+            const detail::token_table* _table = nullptr;
+            size_t _index = 0;
+        };
+
+        TokenRange() = default;
+        explicit TokenRange(const detail::token_table* table): _table(table) {}
+
+        [[nodiscard]] iterator begin() const { return {_table, 0}; }
+        [[nodiscard]] iterator end() const { return {_table, size()}; }
+        [[nodiscard]] size_t size() const { return _table != nullptr ? _table->size() : 0; }
+        [[nodiscard]] bool empty() const { return size() == 0; }
+        [[nodiscard]] Token operator[](const size_t index) const { return (*_table)[index]; }
+    private:
+        const detail::token_table* _table = nullptr;
+    };
+
+    namespace detail {
+        /**
+         * Options in the order they were first given
+         * Entries are stored densely and an open addressing index over entry
+         * numbers finds unregistered keys. The parser appends to both directly,
+         * the sorted order is computed once at the end. Keys are not copied:
+         * they are read from the token bytes, the schema or the key pool.
+         */
+        class option_table {
+        public:
+            static constexpr std::uint32_t unregistered = UINT32_MAX;
+
+            struct entry {
+                std::uint32_t key_offset = 0;        // key in the token bytes, unregistered options without a pool
+                std::uint32_t key_length = 0;
+                std::uint32_t slot = unregistered;   // id of registered options
+                std::uint32_t key_id = unregistered; // interned key
+                std::uint32_t first = 0;             // first value in the views of the result
+                std::uint32_t count = 0;             // number of values
+                std::uint32_t first_run = 0;         // first occurrence in the runs of the result, options with an arity
+                std::uint32_t run_count = 0;
+            };
+
+            /**
+             * Resolve keys that are not stored in the token bytes
+             * @param schema : names of registered options
+             * @param pool : interned keys
+             */
+            void bind(const Schema* schema, KeyPool* pool) {
+                _schema = schema;
+                _pool = pool;
+            }
+            void reserve(const size_t count) { _entries.reserve(count); }
+            /**
+             * Find or append the entry of an unregistered key, without a pool
+             * @param offset : offset of the key in bytes
+             * @param length : length of the key
+             * @param bytes : token bytes
+             * @return entry number
+             */
+            std::uint32_t emplace(const std::uint32_t offset, const std::uint32_t length, const std::string_view bytes) {
+                const std::string_view key = bytes.substr(offset, length);
+                return insert(std::hash<std::string_view>{}(key), bytes, entry{offset, length},
+                              [&](const entry& candidate) { return text(candidate, bytes) == key; });
+            }
+            /**
+             * Find or append the entry of an interned key, compared by id only
+             * @param id : id of the key in the pool
+             * @return entry number
+             */
+            std::uint32_t emplace(const key_id id) {
+                const auto number = static_cast<std::uint32_t>(id);
+                return insert(std::hash<std::uint32_t>{}(number), {}, entry{0, 0, unregistered, number},
+                              [&](const entry& candidate) { return candidate.key_id == number; });
+            }
+            /**
+             * Append the entry of a registered option, found through its id instead of the index
+             * @return entry number
+             */
+            std::uint32_t add_registered(const option_id id) {
+                _entries.push_back({0, 0, static_cast<std::uint32_t>(id)});
+                return static_cast<std::uint32_t>(_entries.size() - 1);
+            }
+            [[nodiscard]] std::string_view key(const entry& entry, const std::string_view bytes) const {
+                if ( entry.slot != unregistered ) return _schema->name(static_cast<option_id>(entry.slot));
+                if ( entry.key_id != unregistered ) return _pool->name(static_cast<key_id>(entry.key_id));
+                return text(entry, bytes);
+            }
+            /**
+             * Compute the sorted order, once every entry is added
+             * @param bytes : token bytes
+             */
+            void build(const std::string_view bytes) {
+                _sorted.resize(_entries.size());
+                for (std::uint32_t i = 0; i < _entries.size(); i++) _sorted[i] = i;
+                std::ranges::sort(_sorted, {}, [&](const std::uint32_t i) { return key(_entries[i], bytes); });
+            }
+
+            [[nodiscard]] const entry* find(const std::string_view key, const std::string_view bytes) const {
+                if ( _buckets.empty() ) return nullptr;
+                if ( _pool != nullptr ) {
+                    const auto id = _pool->find(key);
+                    return id ? find(*id) : nullptr;
+                }
+                const size_t mask = _buckets.size() - 1;
+                for (size_t bucket = std::hash<std::string_view>{}(key) & mask; _buckets[bucket] != 0; bucket = (bucket + 1) & mask) {
+                    const entry& candidate = _entries[_buckets[bucket] - 1];
+                    if ( text(candidate, bytes) == key ) return &candidate;
+                }
+                return nullptr;
+            }
+            [[nodiscard]] const entry* find(const key_id id) const {
+                if ( _buckets.empty() ) return nullptr;
+                const size_t mask = _buckets.size() - 1;
+                const auto number = static_cast<std::uint32_t>(id);
+                for (size_t bucket = std::hash<std::uint32_t>{}(number) & mask; _buckets[bucket] != 0; bucket = (bucket + 1) & mask) {
+                    const entry& candidate = _entries[_buckets[bucket] - 1];
+                    if ( candidate.key_id == number ) return &candidate;
+                }
+                return nullptr;
+            }
+            [[nodiscard]] size_t size() const { return _entries.size(); }
+            [[nodiscard]] entry& operator[](const std::uint32_t number) { return _entries[number]; }
+            [[nodiscard]] const entry& operator[](const std::uint32_t number) const { return _entries[number]; }
+            [[nodiscard]] std::uint32_t number(const entry& entry) const { return static_cast<std::uint32_t>(&entry - _entries.data()); }
+            [[nodiscard]] const std::vector<entry>& entries() const { return _entries; }
+            [[nodiscard]] const std::vector<std::uint32_t>& sorted() const { return _sorted; }
+        private:
+            [[nodiscard]] static std::string_view text(const entry& entry, const std::string_view bytes) {
+                return bytes.substr(entry.key_offset, entry.key_length);
+            }
+            template <typename F>
+            std::uint32_t insert(const size_t hash, const std::string_view bytes, const entry& added, F&& match) {
+                if ( (_indexed + 1) * 2 > _buckets.size() ) grow(bytes);
+                const size_t mask = _buckets.size() - 1;
+                size_t bucket = hash & mask;
+                for (; _buckets[bucket] != 0; bucket = (bucket + 1) & mask)
+                    if ( match(_entries[_buckets[bucket] - 1]) ) return _buckets[bucket] - 1;
+                const auto number = static_cast<std::uint32_t>(_entries.size());
+                _entries.push_back(added);
+                _buckets[bucket] = number + 1;
+                _indexed++;
+                return number;
+            }
+            [[nodiscard]] size_t hash(const entry& entry, const std::string_view bytes) const {
+                if ( entry.key_id != unregistered ) return std::hash<std::uint32_t>{}(entry.key_id);
+                return std::hash<std::string_view>{}(text(entry, bytes));
+            }
+            void grow(const std::string_view bytes) {
+                _buckets.assign(std::max<size_t>(8, _buckets.size() * 2), 0);
+                const size_t mask = _buckets.size() - 1;
+                for (std::uint32_t i = 0; i < _entries.size(); i++) {
+                    if ( _entries[i].slot != unregistered ) continue;
+                    size_t bucket = hash(_entries[i], bytes) & mask;
+                    while ( _buckets[bucket] != 0 ) bucket = (bucket + 1) & mask;
+                    _buckets[bucket] = i + 1;
+                }
+            }
+
+            const Schema* _schema = nullptr;
+            KeyPool* _pool = nullptr;
+            std::vector<entry> _entries;
+            std::vector<std::uint32_t> _buckets; // entry number + 1, 0 when empty
+            size_t _indexed = 0;                 // entries in the index
+            std::vector<std::uint32_t> _sorted;  // entry numbers ordered by key
+        };
+    }
+
+    /**
+     * Options of a result, either as given or sorted by key
+     * Each element is a pair of the key and its values; registered options
+     * are listed under their canonical name.
+     */
+    class OptionRange {
+    public:
+        using value_type = std::pair<std::string_view, std::span<const std::string_view>>;
+
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = OptionRange::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_type;
+
+            iterator() = default;
+            iterator(const OptionRange* range, const size_t index): _range(range), _index(index) {}
+
+            value_type operator*() const { return (*_range)[_index]; }
+            iterator& operator++() { ++_index; return *this; }
+            iterator operator++(int) { auto it = *this; ++_index; return it; }
+            bool operator==(const iterator& other) const { return _index == other._index; }
+        private:
+            const OptionRange* _range = nullptr;
+            size_t _index = 0;
+        };
+
+        OptionRange(const ParseResult& result, const bool sorted): _result(&result), _sorted(sorted) {}
+
+        [[nodiscard]] iterator begin() const { return {this, 0}; }
+        [[nodiscard]] iterator end() const { return {this, size()}; }
+        [[nodiscard]] size_t size() const;
+        [[nodiscard]] bool empty() const { return size() == 0; }
+        [[nodiscard]] value_type operator[](size_t index) const;
+    private:
+        const ParseResult* _result;
+        bool _sorted;
+    };
+
+    /**
+     * Result of argx::parse
+     * Every text is a view into one shared token table, so copying a result
+     * copies no strings. All lookups are const and never modify the result,
+     * so a const ParseResult can be read by any number of threads without locking.
+     */
+    class ParseResult {
+    public:
+        /**
+         * Build a result from containers, as if the equivalent command line was parsed
+         * The tokens list the arguments, then every option with one value, then the flags.
+         * @param args : arguments
+         * @param options : options and their values
+         * @param flags : flags
+         */
+        ParseResult(string_list args, options_map options, string_list flags);
+
+        /**
+         * Get the size of arguments
+         * @return size of arguments
+         */
+        [[nodiscard]] size_t arg_size() const { return _arg_count; }
+        /**
+         * Get the argument at the index or return the default value
+         * @param index : index of the argument
+         * @param def : default value
+         * @return argument at the index or default value
+         */
+        [[nodiscard]] std::string arg_or_def(const int index, const std::string& def) const {
+            if ( index < 0 || static_cast<size_t>(index) >= _arg_count ) return def;
+            return std::string(_views[index]);
+        }
+        /**
+         * Get the argument at the index
+         * @param index : index of the argument
+         * @return argument at the index
+         * @throw std::out_of_range if index is out of range
+         */
+        [[nodiscard]] std::string argument(const int index) const {
+            if ( index < 0 || static_cast<size_t>(index) >= _arg_count ) ARGX_THROW(std::out_of_range("argx:ParseResult:Index out of range:"+std::to_string(index)));
+            return std::string(_views[index]);
+        }
+        /**
+         * Get the list of arguments
+         * @return list of arguments
+         */
+        [[nodiscard]] string_list args() const { return {_views.begin(), _views.begin() + _arg_count}; }
+
+        /**
+         * Get the size of options
+         * @return size of options
+         */
+        [[nodiscard]] size_t option_size() const { return _opts.size(); }
+        /**
+         * Check if the option exists
+         * @param key : key of the option
+         * @return true if the option exists
+         */
+        [[nodiscard]] bool contains(const std::string& key) const {
+            if ( const auto* slot = find_slot(key) ) return slot->count != 0;
+            return _opts.find(key, bytes()) != nullptr;
+        }
+        /**
+         * Check if the registered option exists
+         * @param id : id of the option
+         * @return true if the option exists
+         */
+        [[nodiscard]] bool contains(const option_id id) const { return slot(id).count != 0; }
+        /**
+         * Check if the option with an interned key exists
+         * Only results parsed with a schema that interns keys find anything.
+         * @param id : id of the key in the pool of the schema
+         * @return true if the option exists
+         */
+        [[nodiscard]] bool contains(const key_id id) const { return _opts.find(id) != nullptr; }
+        /**
+         * Get the values of the option with an interned key
+         * @param id : id of the key in the pool of the schema
+         * @return values of the option, empty if it is absent
+         */
+        [[nodiscard]] std::span<const std::string_view> options(const key_id id) const {
+            const auto* entry = _opts.find(id);
+            return entry != nullptr ? values(*entry) : std::span<const std::string_view>{};
+        }
+        /**
+         * Get the option value of the key or return the default value
+         * @param key : key of the option
+         * @param def : default value
+         * @return option value of the key or default value
+         */
+        [[nodiscard]] std::string option_or_def(const std::string& key, const std::string& def) const {
+            const std::string_view* value = find_first(key);
+            return value != nullptr ? std::string(*value) : def;
+        }
+        /**
+         * Get the option value of the key
+         * @param key : key of the option
+         * @return option value of the key
+         * @throw std::out_of_range if key is not found
+         */
+        [[nodiscard]] std::string option(std::string key) const {
+            return option({std::move(key)});
+        }
+        /**
+         * Get the option value of the key or return the default value
+         * @param keys : list of keys
+         * @param def : default value
+         * @return option value of the key or default value
+         */
+        [[nodiscard]] std::string option_or_def(const string_il keys, const std::string& def) const {
+            for(const auto& key : keys) {
+                if ( const std::string_view* value = find_first(key) ) return std::string(*value);
+            }
+            return def;
+        }
+        /**
+         * Get the option value of the key
+         * @param keys : list of keys
+         * @return option value of the key
+         * @throw std::out_of_range if key is not found
+         */
+        [[nodiscard]] std::string option(const string_il keys) const {
+            for(const auto& key : keys) {
+                if ( const std::string_view* value = find_first(key) ) return std::string(*value);
+            }
+            ARGX_THROW(std::out_of_range("argx:ParseResult:Key not found"));
+        }
+        /**
+         * Get the value of the registered option
+         * @param id : id of the option
+         * @return first value of the option, valid as long as the result or its copies
+         * @throw std::out_of_range if the option has no value
+         */
+        [[nodiscard]] std::string_view option(const option_id id) const {
+            const std::string_view* value = first(slot(id));
+            if ( value == nullptr ) ARGX_THROW(std::out_of_range("argx:ParseResult:Key not found"));
+            return *value;
+        }
+        /**
+         * Get the value of the registered option or return the default value
+         * @param id : id of the option
+         * @param def : default value
+         * @return first value of the option or default value
+         */
+        [[nodiscard]] std::string option_or_def(const option_id id, const std::string& def) const {
+            const std::string_view* value = first(slot(id));
+            return value != nullptr ? std::string(*value) : def;
+        }
+        /**
+         * Get the argument at the index without throwing
+         * @param index : index of the argument
+         * @return argument at the index or Error::out_of_range
+         */
+        [[nodiscard]] expected<std::string_view, Error> try_argument(const int index) const {
+            if ( index < 0 || static_cast<size_t>(index) >= _arg_count ) return unexpected<Error>(Error::out_of_range);
+            return _views[index];
+        }
+        /**
+         * Get the option value of the key without throwing
+         * @param key : key of the option
+         * @return first value of the option, Error::not_found or Error::no_value
+         */
+        [[nodiscard]] expected<std::string_view, Error> try_option(const std::string& key) const {
+            if ( const std::string_view* value = find_first(key) ) return *value;
+            return unexpected<Error>(contains(key) ? Error::no_value : Error::not_found);
+        }
+        /**
+         * Get the value of the registered option without throwing
+         * @param id : id of the option
+         * @return first value of the option, Error::unknown_id, Error::not_found or Error::no_value
+         */
+        [[nodiscard]] expected<std::string_view, Error> try_option(const option_id id) const {
+            const auto index = static_cast<size_t>(id);
+            if ( index >= _slots.size() ) return unexpected<Error>(Error::unknown_id);
+            if ( const std::string_view* value = first(_slots[index]) ) return *value;
+            return unexpected<Error>(_slots[index].count != 0 ? Error::no_value : Error::not_found);
+        }
+        /**
+         * Get the list of options
+         * @param key : key of the option
+         * @return list of options
+         */
+        [[nodiscard]] string_list options(const std::string& key) const {
+            const auto values = find_values(key);
+            return {values.begin(), values.end()};
+        }
+        /**
+         * Get the list of options
+         * Aliases of the same registered option are only counted once
+         * @param keys : list of keys
+         * @return list of options
+         */
+        [[nodiscard]] string_list options(const string_il keys) const {
+            string_list result = {};
+            std::vector<option_id> seen = {};
+            for(const auto& key : keys) {
+                if ( _schema != nullptr ) {
+                    if ( const auto id = _schema->find(key) ) {
+                        if ( std::ranges::find(seen, *id) != seen.end() ) continue;
+                        seen.push_back(*id);
+                    }
+                }
+                const auto values = find_values(key);
+                result.insert(result.end(), values.begin(), values.end());
+            }
+            return result;
+        }
+        /**
+         * Get the list of the registered option, merged over all aliases at parse time
+         * Same values as options(key), including every value of an option with an arity.
+         * @param id : id of the option
+         * @return values, valid as long as the result or its copies
+         */
+        [[nodiscard]] std::span<const std::string_view> options(const option_id id) const { return values(slot(id)); }
+        /**
+         * Get every value of an option with an arity, in command line order
+         * @param id : id of the option
+         * @return contiguous values of all occurrences
+         */
+        [[nodiscard]] std::span<const std::string_view> values(const option_id id) const { return values(slot(id)); }
+        /**
+         * Get the values of one occurrence of an option with an arity
+         * Example: -bbox 0 0 4 3 -bbox 1 1 2 2 has two occurrences of four values
+         * @param id : id of the option
+         * @param occurrence : index of the occurrence
+         * @return contiguous values of the occurrence
+         * @throw std::out_of_range if occurrence is out of range
+         */
+        [[nodiscard]] std::span<const std::string_view> values(const option_id id, const size_t occurrence) const {
+            const auto& slot = this->slot(id);
+            if ( occurrence >= occurrences(slot) ) ARGX_THROW(std::out_of_range("argx:ParseResult:Occurrence out of range:"+std::to_string(occurrence)));
+            return run(slot, occurrence);
+        }
+        /**
+         * Convert the option value into a list of numbers
+         * @param key : key of the option
+         * @param delimiter : separator between numbers
+         * @return numbers of the first value, empty if the option has no value
+         * @throw std::invalid_argument if an element is not a number of type T
+         */
+        template <typename T>
+        [[nodiscard]] std::vector<T> option_list(const std::string& key, const char delimiter = ',') const {
+            const std::string_view* value = find_first(key);
+            if ( value == nullptr ) return {};
+            return parse_list<T>(*value, delimiter);
+        }
+        /**
+         * Convert the registered option value into a list of numbers
+         * @param id : id of the option
+         * @param delimiter : separator between numbers
+         * @return numbers of the first value, empty if the option has no value
+         * @throw std::invalid_argument if an element is not a number of type T
+         */
+        template <typename T>
+        [[nodiscard]] std::vector<T> option_list(const option_id id, const char delimiter = ',') const {
+            const std::string_view* value = first(slot(id));
+            if ( value == nullptr ) return {};
+            return parse_list<T>(*value, delimiter);
+        }
+        /**
+         * Get the definitions of a map option
+         * @param id : id of the map option
+         * @return table of definitions
+         */
+        [[nodiscard]] const DefineMap& defines(const option_id id) const { return slot(id).defines; }
+        /**
+         * Get the definitions of a map option
+         * @param key : any alias of the map option
+         * @return table of definitions, empty if the key is not a map option
+         */
+        [[nodiscard]] const DefineMap& defines(const std::string& key) const {
+            static const DefineMap none = {};
+            const auto* slot = find_slot(key);
+            return slot != nullptr ? slot->defines : none;
+        }
+        /**
+         * Get the value of one definition of a map option
+         * @param id : id of the map option
+         * @param name : key of the definition
+         * @return value of the definition or std::nullopt
+         */
+        [[nodiscard]] std::optional<std::string_view> define(const option_id id, const std::string_view name) const {
+            return slot(id).defines.find(name);
+        }
+        /**
+         * Parse the option value as a range expression
+         * @param key : key of the option
+         * @return range expression, empty if the option has no value
+         * @throw std::invalid_argument if the expression is malformed
+         */
+        [[nodiscard]] RangeExpr option_range(const std::string& key) const {
+            const std::string_view* value = find_first(key);
+            if ( value == nullptr ) return {};
+            return RangeExpr(*value);
+        }
+        /**
+         * Parse the registered option value as a range expression
+         * @param id : id of the option
+         * @return range expression, empty if the option has no value
+         * @throw std::invalid_argument if the expression is malformed
+         */
+        [[nodiscard]] RangeExpr option_range(const option_id id) const {
+            const std::string_view* value = first(slot(id));
+            if ( value == nullptr ) return {};
+            return RangeExpr(*value);
+        }
+        /**
+         * Get the map of options
+         * Registered options are listed under their canonical name
+         * @return map of options
+         */
+        [[nodiscard]] options_map options() const {
+            options_map result = {};
+            for (const auto& entry : _opts.entries()) {
+                const auto values = this->values(entry);
+                result.emplace(_opts.key(entry, bytes()), string_list(values.begin(), values.end()));
+            }
+            return result;
+        }
+        /**
+         * Get the options in the order they were first given
+         * Iterating is a linear scan, options with an arity list all their values.
+         * @return options as given, valid as long as the result
+         */
+        [[nodiscard]] OptionRange options_as_given() const { return {*this, false}; }
+        /**
+         * Get the options sorted by key
+         * The order is computed once when the result is built.
+         * @return options sorted by key, valid as long as the result
+         */
+        [[nodiscard]] OptionRange options_sorted() const { return {*this, true}; }
+        /**
+         * Get the size of flags
+         * @return size of flags
+         */
+        [[nodiscard]] size_t flag_size() const {
+            size_t size = _flag_count;
+            for_each_slot(true, [&](const option_id, const detail::slot& slot) { size += slot.count; });
+            return size;
+        }
+        /**
+         * Check if the flag exists
+         * @param flag : flag to check
+         * @return true if the flag exists
+         */
+        [[nodiscard]] bool flag(const std::string& flag) const {
+            if ( _schema != nullptr )
+                if ( const auto id = _schema->find_flag(flag) ) return this->flag(*id);
+            const auto flags = flag_views();
+            return std::ranges::find(flags, flag) != flags.end();
+        }
+        /**
+         * Check if the registered flag exists
+         * @param id : id of the flag
+         * @return true if the flag exists
+         */
+        [[nodiscard]] bool flag(const option_id id) const { return slot(id).count != 0; }
+        /**
+         * Get the number of occurrences of a registered option or flag
+         * @param id : id of the option or flag
+         * @return number of occurrences
+         */
+        [[nodiscard]] size_t count(const option_id id) const { return slot(id).count; }
+        /**
+         * Get the number of occurrences of an option or flag
+         * Unregistered options count their values, unregistered flags their entries
+         * @param key : key of the option or flag
+         * @return number of occurrences
+         */
+        [[nodiscard]] size_t count(const std::string& key) const {
+            if ( _schema != nullptr ) {
+                if ( const auto id = _schema->find(key) ) return count(*id);
+                if ( const auto id = _schema->find_flag(key) ) return count(*id);
+            }
+            if ( const auto* entry = _opts.find(key, bytes()) ) return entry->count;
+            return static_cast<size_t>(std::ranges::count(flag_views(), key));
+        }
+        /**
+         * Get the list of flags
+         * Registered flags are listed under their canonical name
+         * @return list of flags
+         */
+        [[nodiscard]] string_list flags() const {
+            const auto views = flag_views();
+            string_list result(views.begin(), views.end());
+            for_each_slot(true, [&](const option_id id, const detail::slot& slot) {
+                result.insert(result.end(), slot.count, _schema->name(id));
+            });
+            return result;
+        }
+        /**
+         * Get every token in command line order
+         * @return tokens, valid as long as the result or its copies
+         */
+        [[nodiscard]] TokenRange tokens() const { return TokenRange(_tokens.get()); }
+    private:
+        friend struct detail::Collector;
+        friend class Schema;
+        friend class OptionRange;
+
+        static constexpr std::uint32_t none = detail::option_table::unregistered;
+
+        ParseResult() = default;
+
+        [[nodiscard]] std::string_view bytes() const { return _tokens != nullptr ? std::string_view(_tokens->bytes) : std::string_view(); }
+        [[nodiscard]] const detail::slot& slot(const option_id id) const {
+            const auto index = static_cast<size_t>(id);
+            if ( index >= _slots.size() ) ARGX_THROW(std::out_of_range("argx:ParseResult:Unknown id:"+std::to_string(index)));
+            return _slots[index];
+        }
+        [[nodiscard]] const detail::slot* find_slot(const std::string& key) const {
+            if ( _schema == nullptr ) return nullptr;
+            const auto id = _schema->find(key);
+            return id ? &_slots[static_cast<size_t>(*id)] : nullptr;
+        }
+        [[nodiscard]] std::span<const std::string_view> values(const detail::option_table::entry& entry) const {
+            return std::span<const std::string_view>(_views).subspan(entry.first, entry.count);
+        }
+        [[nodiscard]] std::span<const std::string_view> values(const detail::slot& slot) const {
+            if ( slot.entry == none ) return {};
+            return values(_opts[slot.entry]);
+        }
+        [[nodiscard]] size_t occurrences(const detail::slot& slot) const {
+            return slot.entry != none ? _opts[slot.entry].run_count : 0;
+        }
+        [[nodiscard]] std::span<const std::string_view> run(const detail::slot& slot, const size_t occurrence) const {
+            const auto& entry = _opts[slot.entry];
+            const size_t begin = _runs[entry.first_run + occurrence];
+            const size_t end = occurrence + 1 < entry.run_count ? _runs[entry.first_run + occurrence + 1] : entry.count;
+            return values(entry).subspan(begin, end - begin);
+        }
+        [[nodiscard]] std::span<const std::string_view> flag_views() const {
+            return std::span<const std::string_view>(_views).subspan(_arg_count, _flag_count);
+        }
+        [[nodiscard]] const std::string_view* first(const detail::slot& slot) const {
+            const auto values = this->values(slot);
+            return values.empty() ? nullptr : &values.front();
+        }
+        [[nodiscard]] const std::string_view* find_first(const std::string& key) const {
+            const auto values = find_values(key);
+            return values.empty() ? nullptr : &values.front();
+        }
+        [[nodiscard]] std::span<const std::string_view> find_values(const std::string& key) const {
+            if ( const auto* slot = find_slot(key) ) return values(*slot);
+            const auto* entry = _opts.find(key, bytes());
+            return entry != nullptr ? values(*entry) : std::span<const std::string_view>{};
+        }
+        template <typename F>
+        void for_each_slot(const bool flags, F&& f) const {
+            for (size_t i = 0; i < _slots.size(); i++) {
+                const auto id = static_cast<option_id>(i);
+                if ( _slots[i].count != 0 && _schema->is_flag(id) == flags ) f(id, _slots[i]);
+            }
+        }
+
+        std::shared_ptr<const detail::token_table> _tokens;
+        std::vector<std::string_view> _views; // arguments, unregistered flags, then the values of each entry
+        std::uint32_t _arg_count = 0;
+        std::uint32_t _flag_count = 0;
+        detail::option_table _opts;
+        std::vector<std::uint32_t> _runs;     // first value of each occurrence, grouped by entry
+        const Schema* _schema = nullptr;
+        std::vector<detail::slot> _slots;
+        std::vector<std::uint64_t> _present; // one bit per registered id
+    };
+
+    inline size_t OptionRange::size() const { return _result->_opts.size(); }
+
+    inline OptionRange::value_type OptionRange::operator[](const size_t index) const {
+        const auto& table = _result->_opts;
+        const auto& entry = table.entries()[_sorted ? table.sorted()[index] : index];
+        return {table.key(entry, _result->bytes()), _result->values(entry)};
+    }
+
+    template <typename F>
+    bool Schema::check(const ParseResult& result, F&& report) const {
+        if ( result._schema != this ) ARGX_THROW(std::invalid_argument("argx:Schema:Result was not parsed with this schema"));
+        const auto& present = result._present;
+        bool ok = true;
+        for (size_t w = 0; w < _required.size(); w++) {
+            for (std::uint64_t missing = _required[w] & ~detail::word(present, w); missing; missing &= missing - 1) {
+                ok = false;
+                const auto id = static_cast<option_id>(w * 64 + std::countr_zero(missing));
+                if ( !report(Violation{Violation::Kind::missing, id, id, {}}) ) return false;
+            }
+        }
+        for (size_t w = 0; w < present.size(); w++) {
+            for (std::uint64_t ruled = present[w] & detail::word(_ruled, w); ruled; ruled &= ruled - 1) {
+                const size_t index = w * 64 + std::countr_zero(ruled);
+                const auto id = static_cast<option_id>(index);
+                const Entry& entry = _entries[index];
+                for (size_t v = 0; v < entry.conflicts.size(); v++) {
+                    for (std::uint64_t hit = entry.conflicts[v] & detail::word(present, v); hit; hit &= hit - 1) {
+                        const size_t other = v * 64 + std::countr_zero(hit);
+                        if ( other < index ) continue; // Reported from the other side
+                        ok = false;
+                        if ( !report(Violation{Violation::Kind::conflict, id, static_cast<option_id>(other), {}}) ) return false;
+                    }
+                }
+                for (size_t v = 0; v < entry.implies.size(); v++) {
+                    for (std::uint64_t miss = entry.implies[v] & ~detail::word(present, v); miss; miss &= miss - 1) {
+                        ok = false;
+                        const auto other = static_cast<option_id>(v * 64 + std::countr_zero(miss));
+                        if ( !report(Violation{Violation::Kind::implied_missing, id, other, {}}) ) return false;
+                    }
+                }
+                const auto& slot = result._slots[index];
+                if ( entry.arity ) {
+                    for (size_t r = 0; r < result.occurrences(slot); r++) {
+                        if ( result.run(slot, r).size() >= entry.arity->min ) continue;
+                        ok = false;
+                        if ( !report(Violation{Violation::Kind::wrong_arity, id, id, {}}) ) return false;
+                    }
+                }
+                if ( !entry.ranged && entry.allowed.empty() ) continue;
+                const auto check_value = [&](const std::string_view value) {
+                    if ( entry.ranged ) {
+                        double number = 0;
+                        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+                        if ( error != std::errc() || end != value.data() + value.size() || number < entry.min || number > entry.max ) {
+                            ok = false;
+                            if ( !report(Violation{Violation::Kind::out_of_range, id, id, value}) ) return false;
+                        }
+                    }
+                    if ( !entry.allowed.empty() && std::ranges::find(entry.allowed, value) == entry.allowed.end() ) {
+                        ok = false;
+                        if ( !report(Violation{Violation::Kind::not_allowed, id, id, value}) ) return false;
+                    }
+                    return true;
+                };
+                for (const auto value : result.values(slot))
+                    if ( !check_value(value) ) return false;
+            }
+        }
+        return ok;
+    }
+
+    /**
+     * Error thrown when a token is not valid UTF-8
+     */
+    class Utf8Error : public std::invalid_argument {
+    public:
+        Utf8Error(const int index, const size_t offset):
+        std::invalid_argument("argx:parse:Invalid UTF-8:token "+std::to_string(index)+" byte "+std::to_string(offset)),
+        _index(index), _offset(offset) {}
+
+        /**
+         * Get the index of the invalid token in argv
+         * @return index of the token
+         */
+        [[nodiscard]] int index() const { return _index; }
+        /**
+         * Get the byte offset of the first invalid sequence in the token
+         * @return byte offset
+         */
+        [[nodiscard]] size_t offset() const { return _offset; }
+    private:
+        int _index;
+        size_t _offset;
+    };
+
+    namespace detail {
+        /**
+         * Length of the leading ASCII run, 16 bytes per step where SIMD is available
+         */
+        inline size_t ascii_prefix(const unsigned char* data, const size_t size) {
+            size_t i = 0;
+#if defined(__SSE2__)
+            for (; i + 16 <= size; i += 16) {
+                const int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+                if ( mask != 0 ) return i + std::countr_zero(static_cast<unsigned>(mask));
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__) // vmaxvq_u8 is AArch64 only
+            for (; i + 16 <= size; i += 16)
+                if ( vmaxvq_u8(vld1q_u8(data + i)) >= 0x80 ) break;
+#endif
+            while ( i < size && data[i] < 0x80 ) i++;
+            return i;
+        }
+
+        /**
+         * Offset of the first invalid UTF-8 sequence
+         * Rejects overlong forms, surrogates, code points above U+10FFFF and truncated sequences.
+         */
+        inline size_t utf8_scalar(const unsigned char* data, const size_t size, size_t i = 0) {
+            while ( i < size ) {
+                i += ascii_prefix(data + i, size - i);
+                if ( i >= size ) break;
+                const unsigned char lead = data[i];
+                size_t length = 0;
+                unsigned char low = 0x80, high = 0xBF; // Range of the second byte
+                if ( lead >= 0xC2 && lead <= 0xDF ) length = 2;
+                else if ( lead == 0xE0 ) { length = 3; low = 0xA0; }
+                else if ( lead == 0xED ) { length = 3; high = 0x9F; }
+                else if ( lead >= 0xE1 && lead <= 0xEF ) length = 3;
+                else if ( lead == 0xF0 ) { length = 4; low = 0x90; }
+                else if ( lead == 0xF4 ) { length = 4; high = 0x8F; }
+                else if ( lead >= 0xF1 && lead <= 0xF3 ) length = 4;
+                else return i;
+                if ( i + length > size || data[i + 1] < low || data[i + 1] > high ) return i;
+                for (size_t k = 2; k < length; k++)
+                    if ( data[i + k] < 0x80 || data[i + k] > 0xBF ) return i;
+                i += length;
+            }
+            return std::string_view::npos;
+        }
+
+#if defined(__SSSE3__)
+        /**
+         * Vectorized UTF-8 check (Keiser and Lemire lookup algorithm), 16 bytes per step
+         */
+        inline bool utf8_simd(const unsigned char* data, const size_t size) {
+            constexpr std::uint8_t too_short = 1 << 0, too_long = 1 << 1, overlong_3 = 1 << 2, too_large = 1 << 3,
+                surrogate = 1 << 4, overlong_2 = 1 << 5, too_large_1000 = 1 << 6, overlong_4 = 1 << 6, two_conts = 1 << 7;
+            constexpr std::uint8_t carry = too_short | too_long | two_conts;
+            const __m128i byte_1_high_table = _mm_setr_epi8(
+                too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                two_conts, two_conts, two_conts, two_conts,
+                too_short | overlong_2, too_short, too_short | overlong_3 | surrogate,
+                static_cast<char>(too_short | too_large | too_large_1000 | overlong_4));
+            const __m128i byte_1_low_table = _mm_setr_epi8(
+                carry | overlong_3 | overlong_2 | overlong_4, carry | overlong_2, carry, carry,
+                carry | too_large, carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000 | surrogate, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000);
+            const __m128i byte_2_high_table = _mm_setr_epi8(
+                too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                static_cast<char>(too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4),
+                static_cast<char>(too_long | overlong_2 | two_conts | overlong_3 | too_large),
+                static_cast<char>(too_long | overlong_2 | two_conts | surrogate | too_large),
+                static_cast<char>(too_long | overlong_2 | two_conts | surrogate | too_large),
+                too_short, too_short, too_short, too_short);
+            const __m128i incomplete_max = _mm_setr_epi8(
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+
+            __m128i error = _mm_setzero_si128();
+            __m128i previous = _mm_setzero_si128();
+            __m128i incomplete = _mm_setzero_si128();
+            const auto step = [&](const __m128i input) {
+                if ( _mm_movemask_epi8(input) == 0 ) { // ASCII block
+                    error = _mm_or_si128(error, incomplete);
+                } else {
+                    const __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+                    const __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+                    const __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, nibble));
+                    const __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+                    const __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+                    const __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+                    const __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+                    const __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 1)));
+                    const __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 1)));
+                    const __m128i must23 = _mm_cmpgt_epi8(_mm_or_si128(third, fourth), _mm_setzero_si128());
+                    error = _mm_or_si128(error, _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80))), special));
+                    incomplete = _mm_subs_epu8(input, incomplete_max);
+                }
+                previous = input;
+            };
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16)
+                step(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+            if ( i < size ) {
+                alignas(16) unsigned char tail[16] = {};
+                std::memcpy(tail, data + i, size - i);
+                step(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)));
+            }
+            error = _mm_or_si128(error, incomplete);
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+        }
+#endif
+    }
+
+    /**
+     * Find the first invalid UTF-8 sequence
+     * Uses a vectorized validator when SSSE3 is enabled, otherwise
+     * skips ASCII runs with SSE2 or NEON and checks the rest byte by byte.
+     * @param text : text to check
+     * @return byte offset of the first invalid sequence, or std::string_view::npos if valid
+     */
+    inline size_t utf8_error(const std::string_view text) {
+        const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+#if defined(__SSSE3__)
+        if ( detail::utf8_simd(data, text.size()) ) return std::string_view::npos;
+#endif
+        return detail::utf8_scalar(data, text.size());
+    }
+
+    /**
+     * Check that every token is valid UTF-8
+     * @param argc : number of arguments
+     * @param argv : arguments
+     * @throw argx::Utf8Error with the index and byte offset of the first invalid token
+     */
+    inline void check_utf8(const int argc, char **argv) {
+        for (int i = 0; i < argc; i++) {
+            const size_t offset = utf8_error(argv[i]);
+            if ( offset != std::string_view::npos ) ARGX_THROW(Utf8Error(i, offset));
+        }
+    }
+
+    namespace detail {
+        enum class token_kind { none, argument, option, flag };
+
+        struct token {
+            token_kind kind;
+            std::string_view name;
+        };
+
+        /**
+         * Classify one command line token by its dash prefix
+         * Tokens made only of dashes (and empty tokens) are ignored
+         */
+        constexpr token classify(const std::string_view target) {
+            const size_t prefix = target.find_first_not_of('-');
+            if (prefix == std::string_view::npos) return {token_kind::none, {}};
+            if (prefix >= 2) return {token_kind::flag, target.substr(prefix)};
+            if (prefix == 1) return {token_kind::option, target.substr(prefix)};
+            return {token_kind::argument, target};
+        }
+
+        /**
+         * Incremental state of the parse loop
+         * Tokens go straight into the token table and options into the flat
+         * option table, values are only laid out as views once parsing ends.
+         */
+        struct Collector {
+            static constexpr std::uint32_t none = option_table::unregistered;
+
+            struct step {
+                token tok;
+                TokenKind kind;      // recorded role, value when the token is bound to an option
+                std::uint32_t owner; // option entry of the token, none for arguments and flags
+            };
+
+            const Schema* schema = nullptr;
+            token_table tokens = {};
+            option_table options = {};
+            std::vector<slot> slots = {};
+            std::vector<std::uint64_t> present = {};
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> runs = {}; // entry and first value of each occurrence with an arity
+            std::uint32_t arguments = 0;    // positional arguments
+            std::uint32_t flags = 0;        // unregistered flags
+            std::uint32_t previous = none;  // entry taking the next value
+            std::uint32_t pending = none;   // entry with an arity still taking values
+            std::uint32_t pending_left = 0;
+            std::uint32_t position = 0;     // argv index of the next token
+            std::uint32_t key_offset = 0;   // name of the last option in tokens.bytes, or its key id
+            std::uint32_t key_length = 0;
+
+            Collector() = default;
+            explicit Collector(const Schema& schema): schema(&schema), slots(schema.size()), present((schema.size() + 63) / 64, 0) {
+                options.bind(&schema, schema.pool());
+                tokens.pool = schema.pool();
+            }
+
+            /**
+             * Size the token table for all tokens, so recording costs no further allocation
+             * Single pass ranges are not measured.
+             */
+            template <typename R>
+            void reserve(R& source) {
+                if constexpr ( std::ranges::forward_range<R> ) {
+                    size_t count = 0, size = 0;
+                    for (const std::string_view token : source) {
+                        count++;
+                        size += token.size();
+                    }
+                    tokens.reserve(count, size);
+                    options.reserve(count);
+                }
+            }
+
+            step push(const std::string_view target) {
+                const token tok = classify(target);
+                const std::uint32_t index = position++;
+                switch (tok.kind) {
+                    case token_kind::flag:
+                        flag(tok.name, index);
+                        return {tok, TokenKind::flag, none};
+                    case token_kind::option:
+                        return {tok, TokenKind::option, option(tok.name, index)};
+                    case token_kind::argument: {
+                        const std::uint32_t owner = argument(tok.name, index);
+                        return {tok, owner != none ? TokenKind::value : TokenKind::argument, owner};
+                    }
+                    case token_kind::none:
+                        break;
+                }
+                return {tok, TokenKind::argument, none};
+            }
+
+            void flag(const std::string_view name, const std::uint32_t index) {
+                previous = pending = none;
+                std::uint32_t owner = none;
+                if ( auto* slot = registered(name, true) ) {
+                    slot->count++;
+                    owner = static_cast<std::uint32_t>(id(slot));
+                } else {
+                    flags++;
+                }
+                tokens.push(TokenKind::flag, tokens.append(name), static_cast<std::uint32_t>(name.size()), 0, 0, index, owner);
+            }
+
+            /**
+             * @return entry of the option
+             */
+            std::uint32_t option(const std::string_view name, const std::uint32_t index) {
+                previous = pending = none;
+                std::uint32_t number = none;
+                if ( auto* slot = registered(name, false) ) {
+                    key_offset = tokens.append(name);
+                    key_length = static_cast<std::uint32_t>(name.size());
+                    if ( slot->count++ == 0 ) slot->entry = options.add_registered(id(slot));
+                    number = slot->entry;
+                    if ( const auto arity = schema->arity(id(slot)) ) {
+                        runs.emplace_back(number, options[number].count);
+                        options[number].run_count++;
+                        if ( arity->max != 0 ) {
+                            pending = number;
+                            pending_left = arity->max;
+                        }
+                    } else if ( schema->storage(id(slot)) != Storage::count ) { // Counted options take no value
+                        previous = number;
+                    }
+                } else if ( KeyPool* pool = schema != nullptr ? schema->pool() : nullptr ) {
+                    const key_id id = pool->intern(name);
+                    key_offset = static_cast<std::uint32_t>(id);
+                    key_length = token_table::interned;
+                    number = previous = options.emplace(id);
+                } else {
+                    key_offset = tokens.append(name);
+                    key_length = static_cast<std::uint32_t>(name.size());
+                    number = previous = options.emplace(key_offset, key_length, tokens.bytes);
+                }
+                tokens.push(TokenKind::option, key_offset, key_length, 0, 0, index, number);
+                return number;
+            }
+
+            /**
+             * @return entry the token is bound to as a value, none for a positional argument
+             */
+            std::uint32_t argument(const std::string_view text, const std::uint32_t index) {
+                const std::uint32_t offset = tokens.append(text);
+                const auto length = static_cast<std::uint32_t>(text.size());
+                if ( pending != none ) {
+                    const std::uint32_t owner = pending;
+                    options[owner].count++;
+                    if ( --pending_left == 0 ) pending = none;
+                    tokens.push(TokenKind::value, key_offset, key_length, offset, length, index, owner);
+                    return owner;
+                }
+                if ( previous == none ) {
+                    arguments++;
+                    tokens.push(TokenKind::argument, 0, 0, offset, length, index, none);
+                    return none;
+                }
+                const std::uint32_t owner = std::exchange(previous, none);
+                auto& entry = options[owner];
+                slot* slot = entry.slot != none ? &slots[entry.slot] : nullptr;
+                const Storage policy = slot != nullptr ? schema->storage(static_cast<option_id>(entry.slot)) : Storage::append;
+                std::uint32_t bound = owner;
+                if ( entry.count == 0 || policy == Storage::append ) entry.count++;
+                else if ( policy == Storage::first ) bound = none;
+                else tokens.set(token_table::owners, slot->kept, none); // Storage::last, the new value replaces the kept one
+                if ( slot != nullptr ) slot->kept = static_cast<std::uint32_t>(tokens.size());
+                tokens.push(TokenKind::value, key_offset, key_length, offset, length, index, bound);
+                return owner;
+            }
+
+            /**
+             * Lay out the values of every entry as views into the shared token table
+             */
+            ParseResult finish() {
+                previous = pending = none;
+                ParseResult result;
+                result._tokens = std::make_shared<const token_table>(std::move(tokens));
+                const token_table& table = *result._tokens;
+                std::uint32_t cursor = arguments + flags;
+                std::uint32_t run_cursor = 0;
+                for (std::uint32_t e = 0; e < options.size(); e++) {
+                    auto& entry = options[e];
+                    entry.first = cursor;
+                    cursor += std::exchange(entry.count, 0);
+                    entry.first_run = run_cursor;
+                    run_cursor += std::exchange(entry.run_count, 0);
+                }
+                result._views.resize(cursor);
+                result._runs.resize(run_cursor);
+                for (const auto& [number, start] : runs) {
+                    auto& entry = options[number];
+                    result._runs[entry.first_run + entry.run_count++] = start;
+                }
+                std::uint32_t next_argument = 0;
+                std::uint32_t next_flag = arguments;
+                for (size_t i = 0; i < table.size(); i++) {
+                    const std::uint32_t owner = table.at(token_table::owners, i);
+                    switch (table.kind(i)) {
+                        case TokenKind::argument:
+                            result._views[next_argument++] = table.value(i);
+                            break;
+                        case TokenKind::flag:
+                            if ( owner == none ) result._views[next_flag++] = table.key(i);
+                            break;
+                        case TokenKind::value:
+                            if ( owner != none ) {
+                                auto& entry = options[owner];
+                                result._views[entry.first + entry.count++] = table.value(i);
+                            }
+                            break;
+                        case TokenKind::option:
+                            break;
+                    }
+                }
+                for (size_t i = 0; i < slots.size(); i++) {
+                    const auto id = static_cast<option_id>(i);
+                    if ( slots[i].entry == none || !schema->is_map(id) ) continue;
+                    const auto& entry = options[slots[i].entry];
+                    for (std::uint32_t v = 0; v < entry.count; v++)
+                        slots[i].defines.insert(result._views[entry.first + v], schema->duplicates(id));
+                }
+                options.build(table.bytes);
+                result._arg_count = arguments;
+                result._flag_count = flags;
+                result._opts = std::move(options);
+                result._schema = schema;
+                result._slots = std::move(slots);
+                result._present = std::move(present);
+                return result;
+            }
+
+            option_id id(const slot* slot) const { return static_cast<option_id>(slot - slots.data()); }
+
+            slot* registered(const std::string_view name, const bool flag) {
+                if ( schema == nullptr ) return nullptr;
+                const auto id = flag ? schema->find_flag(name) : schema->find(name);
+                if ( !id ) return nullptr;
+                const auto index = static_cast<size_t>(*id);
+                detail::set_bit(present, index);
+                return &slots[index];
+            }
+        };
+    }
+
+    /**
+     * Build a result from containers through the same collector as argx::parse
+     */
+    inline ParseResult::ParseResult(string_list args, options_map options, string_list flags) {
+        detail::Collector collector;
+        std::uint32_t index = 0;
+        for (const auto& argument : args) collector.argument(argument, index++);
+        for (const auto& [key, values] : options) {
+            if ( values.empty() ) collector.option(key, index++);
+            for (const auto& value : values) {
+                collector.option(key, index++);
+                collector.argument(value, index++);
+            }
+        }
+        for (const auto& flag : flags) collector.flag(flag, index++);
+        *this = collector.finish();
+    }
+
+    /**
+     * One command line token classified by its dash prefix, before values are bound to options
+     */
+    struct ClassifiedToken {
+        TokenKind kind;        // argument, option or flag
+        std::string_view name; // without dashes
+    };
+
+    /**
+     * Classify one command line token the way the parser does
+     * Generated parsers call this for every token.
+     * @param target : command line token
+     * @return kind and name, std::nullopt for empty tokens and tokens made only of dashes
+     */
+    constexpr std::optional<ClassifiedToken> classify(const std::string_view target) {
+        const auto tok = detail::classify(target);
+        switch (tok.kind) {
+            case detail::token_kind::argument: return ClassifiedToken{TokenKind::argument, tok.name};
+            case detail::token_kind::option: return ClassifiedToken{TokenKind::option, tok.name};
+            case detail::token_kind::flag: return ClassifiedToken{TokenKind::flag, tok.name};
+            case detail::token_kind::none: break;
+        }
+        return std::nullopt;
+    }
+
+    namespace detail {
+        /**
+         * Any range of string-like tokens: argv spans, std::vector<std::string>, views...
+         */
+        template <typename R>
+        concept token_source = std::ranges::input_range<R>
+            && std::convertible_to<std::ranges::range_reference_t<R>, std::string_view>;
+
+        /**
+         * Position of the first token that is not valid UTF-8
+         */
+        struct utf8_failure {
+            int index;
+            size_t offset;
+        };
+
+        /**
+         * Feed every token of the source to the collector in a single pass, without throwing
+         * @return the invalid token if utf8 is set and a token is not valid UTF-8
+         */
+        template <typename R>
+        std::optional<utf8_failure> feed(Collector& collector, R&& source, const bool utf8) {
+            collector.reserve(source);
+            int index = 0;
+            for (const std::string_view token : source) {
+                if ( utf8 ) {
+                    const size_t offset = utf8_error(token);
+                    if ( offset != std::string_view::npos ) return utf8_failure{index, offset};
+                }
+                collector.push(token);
+                index++;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * Feed every token of the source to the collector in a single pass
+         */
+        template <typename R>
+        ParseResult collect(Collector& collector, R&& source, const bool utf8 = false) {
+            if ( const auto failure = feed(collector, source, utf8) ) ARGX_THROW(Utf8Error(failure->index, failure->offset));
+            return collector.finish();
+        }
+
+        inline std::span<char* const> argv_span(const int argc, char **argv) {
+            return {argv, static_cast<size_t>(std::max(argc, 0))};
+        }
+    }
+
+    /**
+     * Parse tokens from any range of string-like elements
+     * Tokens are read as string views, no temporary char* array is built.
+     * Their bytes are copied once into the token table, stable views included,
+     * so the result does not depend on the lifetime of the source.
+     * @param source : tokens, e.g. std::vector<std::string> or std::span<const std::string_view>
+     * @return parse result
+     */
+    template <detail::token_source R>
+    ParseResult parse(R&& source) {
+        detail::Collector collector;
+        return detail::collect(collector, source);
+    }
+
+    /**
+     * Parse tokens from any range of string-like elements with a schema
+     * @param schema : known options and flags, must outlive the result
+     * @param source : tokens, e.g. std::vector<std::string> or std::span<const std::string_view>
+     * @return parse result
+     * @throw argx::Utf8Error if the schema requires UTF-8 and a token is invalid
+     */
+    template <detail::token_source R>
+    ParseResult parse(const Schema& schema, R&& source) {
+        detail::Collector collector(schema);
+        return detail::collect(collector, source, schema.utf8());
+    }
+
+    inline ParseResult parse(const int argc, char **argv) {
+        return parse(detail::argv_span(argc, argv));
+    }
+
+    /**
+     * Parse with a schema, so every alias of a registered option
+     * resolves to its canonical id while parsing
+     * @param schema : known options and flags, must outlive the result
+     * @param argc : number of arguments
+     * @param argv : arguments
+     * @return parse result
+     * @throw argx::Utf8Error if the schema requires UTF-8 and a token is invalid
+     */
+    inline ParseResult parse(const Schema& schema, const int argc, char **argv) {
+        return parse(schema, detail::argv_span(argc, argv));
+    }
+
+    /**
+     * Tokens of a NUL separated buffer, e.g. the contents of /proc/<pid>/cmdline
+     * A trailing NUL ends the last token instead of starting an empty one.
+     */
+    class NulSeparated {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = std::string_view;
+
+            iterator() = default;
+            iterator(const std::string_view buffer, const size_t position): _buffer(buffer), _position(position) { find_stop(); }
+
+            std::string_view operator*() const { return _buffer.substr(_position, _stop - _position); }
+            iterator& operator++() {
+                _position = std::min(_stop + 1, _buffer.size());
+                find_stop();
+                return *this;
+            }
+            iterator operator++(int) { auto it = *this; ++*this; return it; }
+            bool operator==(const iterator& other) const { return _position == other._position; }
+        private:
+            void find_stop() {
+                const void* nul = std::memchr(_buffer.data() + _position, '\0', _buffer.size() - _position);
+                _stop = nul != nullptr ? static_cast<size_t>(static_cast<const char*>(nul) - _buffer.data()) : _buffer.size();
+            }
+
+            std::string_view _buffer = {};
+            size_t _position = 0;
+            size_t _stop = 0;
+        };
+
+        explicit NulSeparated(const std::string_view buffer): _buffer(buffer) {}
+
+        [[nodiscard]] iterator begin() const { return {_buffer, 0}; }
+        [[nodiscard]] iterator end() const { return {_buffer, _buffer.size()}; }
+    private:
+        std::string_view _buffer;
+    };
+
+    /**
+     * Parse a NUL separated buffer, e.g. the contents of /proc/<pid>/cmdline
+     * Tokens are split in place with the same rules as argx::parse.
+     * @param buffer : NUL separated tokens
+     * @return parse result
+     */
+    inline ParseResult parse_nul_separated(const std::string_view buffer) {
+        return parse(NulSeparated(buffer));
+    }
+
+    /**
+     * Parse a NUL separated buffer with a schema
+     * @param schema : known options and flags, must outlive the result
+     * @param buffer : NUL separated tokens
+     * @return parse result
+     * @throw argx::Utf8Error if the schema requires UTF-8 and a token is invalid
+     */
+    inline ParseResult parse_nul_separated(const Schema& schema, const std::string_view buffer) {
+        return parse(schema, NulSeparated(buffer));
+    }
+
+    /**
+     * Parse with a schema without throwing on malformed input
+     * @param schema : known options and flags, must outlive the result
+     * @param argc : number of arguments
+     * @param argv : arguments
+     * @return parse result, or Error::invalid_utf8 if the schema requires UTF-8 and a token is invalid
+     */
+    inline expected<ParseResult, Error> try_parse(const Schema& schema, const int argc, char **argv) {
+        detail::Collector collector(schema);
+        if ( detail::feed(collector, detail::argv_span(argc, argv), schema.utf8()) ) return unexpected<Error>(Error::invalid_utf8);
+        return collector.finish();
+    }
+
+    namespace detail {
+        inline size_t dash_prefix(const char* target) {
+            size_t prefix = 0;
+            while (target[prefix] == '-') prefix++;
+            return prefix;
+        }
+
+        /**
+         * Compare a NUL terminated token with a name without measuring the token first
+         */
+        inline bool matches(const char* target, const std::string_view name) {
+            return std::strncmp(target, name.data(), name.size()) == 0 && target[name.size()] == '\0';
+        }
+    }
+
+    /**
+     * Check if a flag exists without building a ParseResult
+     * Uses the same prefix rules as argx::parse and never allocates
+     * @param argc : number of arguments
+     * @param argv : arguments
+     * @param name : flag to check, without dashes
+     * @return true if the flag exists
+     */
+    inline bool has_flag(const int argc, char **argv, const std::string_view name) {
+        if ( name.empty() || name.find('\0') != std::string_view::npos ) return false;
+        for (int i = 0; i < argc; i++) {
+            const char* target = argv[i];
+            const size_t prefix = detail::dash_prefix(target);
+            if ( prefix >= 2 && detail::matches(target + prefix, name) ) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Find the first value of an option without building a ParseResult
+     * Uses the same prefix rules as argx::parse and never allocates
+     * @param argc : number of arguments
+     * @param argv : arguments
+     * @param name : key of the option, without the dash
+     * @return first value of the option, or std::nullopt if it has none
+     */
+    inline std::optional<std::string_view> find_option(const int argc, char **argv, const std::string_view name) {
+        if ( name.empty() || name.find('\0') != std::string_view::npos ) return std::nullopt;
+        bool pending = false;
+        for (int i = 0; i < argc; i++) {
+            const char* target = argv[i];
+            const size_t prefix = detail::dash_prefix(target);
+            if ( target[prefix] == '\0' ) continue; // Ignored
+            if ( prefix == 0 ) { // Argument
+                if ( pending ) return std::string_view(target);
+                continue;
+            }
+            pending = prefix == 1 && detail::matches(target + 1, name);
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * Binding of one option, flag or the arguments to a struct member
+     * bool members bind to flags (--name), other members to options (-name),
+     * std::vector members collect every value. Other members keep the first
+     * value, like ParseResult::option. std::optional members are engaged only
+     * when a value is given, so an option without a value leaves them empty.
+     * std::optional<bool> and std::vector<bool> members take true, false, 1 or 0.
+     */
+    template <typename T, typename M>
+    struct Field {
+        std::string_view names; // comma separated aliases, empty for the arguments
+        M T::* member;
+    };
+
+    /**
+     * Bind an option or flag to a member
+     * @param names : comma separated aliases, e.g. "threads,t"
+     * @param member : member pointer
+     * @return field binding
+     */
+    template <typename T, typename M>
+    constexpr Field<T, M> field(const std::string_view names, M T::* member) { return {names, member}; }
+    /**
+     * Bind the arguments to a member
+     * @param member : member pointer, a std::vector collects every argument
+     * @return field binding
+     */
+    template <typename T, typename M>
+    constexpr Field<T, M> arguments(M T::* member) { return {{}, member}; }
+
+    /**
+     * Table of fields of a struct, specialize with a static constexpr tuple `fields`
+     * or use ARGX_BIND(Type, ARGX_FIELD(Type, member), ...).
+     */
+    template <typename T>
+    struct Binding;
+
+#define ARGX_FIELD(Type, member) ::argx::field(#member, &Type::member)
+#define ARGX_BIND(Type, ...) template <> struct argx::Binding<Type> { static constexpr auto fields = std::tuple{__VA_ARGS__}; }
+
+    namespace detail {
+        constexpr bool alias_match(std::string_view names, const std::string_view name) {
+            while ( !names.empty() ) {
+                const size_t comma = std::min(names.find(','), names.size());
+                if ( names.substr(0, comma) == name ) return true;
+                names.remove_prefix(std::min(comma + 1, names.size()));
+            }
+            return false;
+        }
+
+        template <typename V>
+        struct is_vector : std::false_type {};
+        template <typename V>
+        struct is_vector<std::vector<V>> : std::true_type {};
+        template <typename V>
+        struct is_optional : std::false_type {};
+        template <typename V>
+        struct is_optional<std::optional<V>> : std::true_type {};
+
+        template <typename V>
+        void assign(V& target, const std::string_view text, const std::string_view name) {
+            if constexpr ( is_vector<V>::value ) {
+                typename V::value_type value = {};
+                assign(value, text, name);
+                target.push_back(std::move(value));
+            } else if constexpr ( is_optional<V>::value ) {
+                typename V::value_type value = {};
+                assign(value, text, name);
+                target = std::move(value);
+            } else if constexpr ( std::is_same_v<V, bool> ) {
+                if ( text == "true" || text == "1" ) target = true;
+                else if ( text == "false" || text == "0" ) target = false;
+                else ARGX_THROW(std::invalid_argument("argx:parse_into:Invalid value:"+std::string(name)+"="+std::string(text)));
+            } else if constexpr ( std::is_arithmetic_v<V> ) {
+                const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), target);
+                if ( error != std::errc() || end != text.data() + text.size() )
+                    ARGX_THROW(std::invalid_argument("argx:parse_into:Invalid value:"+std::string(name)+"="+std::string(text)));
+            } else if constexpr ( std::is_constructible_v<V, std::string_view> ) {
+                target = V(text);
+            } else {
+                static_assert(std::is_constructible_v<V, std::string_view>,
+                              "argx::parse_into: members must be arithmetic, bool, constructible from std::string_view, "
+                              "or a std::vector or std::optional of those");
+            }
+        }
+
+        template <typename Fields, typename F>
+        constexpr void visit_field(const Fields& fields, const size_t index, F&& f) {
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (void)((I == index ? (f(std::get<I>(fields)), true) : false) || ...);
+            }(std::make_index_sequence<std::tuple_size_v<Fields>>{});
+        }
+
+        template <typename T, typename M>
+        constexpr bool binds(const Field<T, M>& field, const token_kind kind, const std::string_view name) {
+            if ( kind == token_kind::argument ) return field.names.empty();
+            if ( field.names.empty() || (kind == token_kind::flag) != std::is_same_v<M, bool> ) return false;
+            return alias_match(field.names, name);
+        }
+
+        /**
+         * Index of the field bound to a token, or npos
+         * bool members bind to flags, other members to options, unnamed fields to arguments
+         */
+        template <typename Fields>
+        constexpr size_t find_field(const Fields& fields, const token_kind kind, const std::string_view name) {
+            size_t found = std::string_view::npos;
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (void)((binds(std::get<I>(fields), kind, name) ? (found = I, true) : false) || ...);
+            }(std::make_index_sequence<std::tuple_size_v<Fields>>{});
+            return found;
+        }
+    }
+
+    /**
+     * Convert a value into a member the way argx::parse_into does
+     * Generated parsers call this for every option value.
+     * @param target : member to write, std::vector members append the value
+     * @param text : value
+     * @param name : option name, for the error message
+     * @throw std::invalid_argument if text cannot be converted to the member type
+     */
+    template <typename V>
+    void assign(V& target, const std::string_view text, const std::string_view name) {
+        detail::assign(target, text, name);
+    }
+
+    /**
+     * Parse straight into a struct, without building a ParseResult
+     * Values are converted once, in the same single pass over argv as argx::parse.
+     * Tokens without a bound member are skipped.
+     * @param target : struct with an argx::Binding specialization
+     * @param argc : number of arguments
+     * @param argv : arguments
+     * @throw std::invalid_argument if a value cannot be converted to its member type
+     */
+    template <typename T>
+    void parse_into(T& target, const int argc, char **argv) {
+        constexpr auto& fields = Binding<T>::fields;
+        std::array<bool, std::tuple_size_v<std::remove_cvref_t<decltype(fields)>>> assigned = {};
+        bool after_option = false;
+        size_t pending = std::string_view::npos;
+        for (int i = 0; i < argc; i++) {
+            const auto tok = detail::classify(argv[i]);
+            switch (tok.kind) {
+                case detail::token_kind::flag: {
+                    after_option = false;
+                    const size_t index = detail::find_field(fields, tok.kind, tok.name);
+                    detail::visit_field(fields, index, [&](const auto& field) {
+                        if constexpr ( std::is_same_v<std::remove_cvref_t<decltype(target.*field.member)>, bool> )
+                            target.*field.member = true;
+                    });
+                    break;
+                }
+                case detail::token_kind::option:
+                    after_option = true;
+                    pending = detail::find_field(fields, tok.kind, tok.name);
+                    break;
+                case detail::token_kind::argument: {
+                    const size_t index = after_option ? pending : detail::find_field(fields, tok.kind, {});
+                    after_option = false;
+                    pending = std::string_view::npos;
+                    detail::visit_field(fields, index, [&](const auto& field) {
+                        using M = std::remove_cvref_t<decltype(target.*field.member)>;
+                        if constexpr ( !std::is_same_v<M, bool> ) {
+                            if ( !detail::is_vector<M>::value && std::exchange(assigned[index], true) ) return; // First value wins
+                            detail::assign(target.*field.member, tok.name, field.names.substr(0, field.names.find(',')));
+                        }
+                    });
+                    break;
+                }
+                case detail::token_kind::none:
+                    break;
+            }
+        }
+    }
+
+    /**
+     * Parse straight into a new struct
+     * @param argc : number of arguments
+     * @param argv : arguments
+     * @return struct holding the bound values, other members keep their defaults
+     * @throw std::invalid_argument if a value cannot be converted to its member type
+     */
+    template <typename T>
+    T parse_into(const int argc, char **argv) {
+        T target = {};
+        parse_into(target, argc, argv);
+        return target;
+    }
+
+    /**
+     * Parse result that scans argv only as far as each query needs
+     * argv must outlive the LazyResult. Tokens consumed by one query
+     * are not scanned again by later queries. Queries advance the scan,
+     * so a LazyResult must not be shared between threads.
+     */
+    class LazyResult {
+    public:
+        LazyResult(const int argc, char **argv): _argc(argc), _argv(argv) {}
+
+        /**
+         * Get the number of argv entries consumed so far
+         * @return number of consumed entries
+         */
+        [[nodiscard]] size_t consumed() const { return _next; }
+        /**
+         * Check if the whole argv has been consumed
+         * @return true if nothing is left to scan
+         */
+        [[nodiscard]] bool done() const { return _next >= _argc; }
+
+        /**
+         * Get the size of arguments, scans the whole argv
+         * @return size of arguments
+         */
+        [[nodiscard]] size_t arg_size() { scan_all(); return _arguments.size(); }
+        /**
+         * Get the argument at the index or return the default value
+         * @param index : index of the argument
+         * @param def : default value
+         * @return argument at the index or default value
+         */
+        [[nodiscard]] std::string arg_or_def(const int index, const std::string& def) {
+            if ( index < 0 || !scan_args(index) ) return def;
+            return std::string(_arguments[index]);
+        }
+        /**
+         * Get the argument at the index
+         * @param index : index of the argument
+         * @return argument at the index
+         * @throw std::out_of_range if index is out of range
+         */
+        [[nodiscard]] std::string argument(const int index) {
+            if ( index < 0 || !scan_args(index) ) ARGX_THROW(std::out_of_range("argx:LazyResult:Index out of range:"+std::to_string(index)));
+            return std::string(_arguments[index]);
+        }
+        /**
+         * Get the list of arguments, scans the whole argv
+         * @return list of arguments
+         */
+        [[nodiscard]] string_list args() { scan_all(); return {_arguments.begin(), _arguments.end()}; }
+
+        /**
+         * Get the size of options, scans the whole argv
+         * @return size of options
+         */
+        [[nodiscard]] size_t option_size() { scan_all(); return _state.options.size(); }
+        /**
+         * Check if the option exists, stops at its first occurrence
+         * @param key : key of the option
+         * @return true if the option exists
+         */
+        [[nodiscard]] bool contains(const std::string& key) {
+            if ( find(key) != nullptr ) return true;
+            while ( !done() ) {
+                const auto step = push();
+                if ( step.kind == TokenKind::option && step.tok.name == key ) return true;
+            }
+            return false;
+        }
+        /**
+         * Get the option value of the key or return the default value
+         * Stops as soon as the first value of the key is known
+         * @param key : key of the option
+         * @param def : default value
+         * @return option value of the key or default value
+         */
+        [[nodiscard]] std::string option_or_def(const std::string& key, const std::string& def) {
+            const auto value = scan_first_value(key);
+            return value ? std::string(*value) : def;
+        }
+        /**
+         * Get the option value of the key
+         * Stops as soon as the first value of the key is known
+         * @param key : key of the option
+         * @return option value of the key
+         * @throw std::out_of_range if key is not found
+         */
+        [[nodiscard]] std::string option(const std::string& key) {
+            const auto value = scan_first_value(key);
+            if ( !value ) ARGX_THROW(std::out_of_range("argx:LazyResult:Key not found"));
+            return std::string(*value);
+        }
+        /**
+         * Get the list of options, scans the whole argv since the key may repeat
+         * @param key : key of the option
+         * @return list of options
+         */
+        [[nodiscard]] string_list options(const std::string& key) {
+            scan_all();
+            string_list result = {};
+            if ( const auto* entry = find(key) ) {
+                const std::uint32_t number = _state.options.number(*entry);
+                for (const auto& [owner, value] : _values)
+                    if ( owner == number ) result.emplace_back(value);
+            }
+            return result;
+        }
+        /**
+         * Get the map of options, scans the whole argv
+         * @return map of options
+         */
+        [[nodiscard]] options_map options() {
+            scan_all();
+            options_map result = {};
+            std::vector<string_list*> lists = {};
+            for (const auto& entry : _state.options.entries())
+                lists.push_back(&result[std::string(_state.options.key(entry, _state.tokens.bytes))]);
+            for (const auto& [owner, value] : _values) lists[owner]->emplace_back(value);
+            return result;
+        }
+
+        /**
+         * Get the size of flags, scans the whole argv
+         * @return size of flags
+         */
+        [[nodiscard]] size_t flag_size() { scan_all(); return _flags.size(); }
+        /**
+         * Check if the flag exists, stops at its first occurrence
+         * @param flag : flag to check
+         * @return true if the flag exists
+         */
+        [[nodiscard]] bool flag(const std::string& flag) {
+            if ( std::ranges::find(_flags, flag) != _flags.end() ) return true;
+            while ( !done() ) {
+                const auto step = push();
+                if ( step.kind == TokenKind::flag && step.tok.name == flag ) return true;
+            }
+            return false;
+        }
+        /**
+         * Get the list of flags, scans the whole argv
+         * @return list of flags
+         */
+        [[nodiscard]] string_list flags() { scan_all(); return {_flags.begin(), _flags.end()}; }
+
+        /**
+         * Finish scanning and convert to a ParseResult
+         * @return parse result of the whole argv
+         */
+        [[nodiscard]] ParseResult result() {
+            scan_all();
+            detail::Collector state = _state;
+            return state.finish();
+        }
+    private:
+        /**
+         * Scan one more entry, remembering views of arguments, flags and values into argv
+         */
+        detail::Collector::step push() {
+            const auto step = _state.push(_argv[_next++]);
+            if ( step.tok.kind == detail::token_kind::none ) return step;
+            if ( step.kind == TokenKind::argument ) _arguments.push_back(step.tok.name);
+            else if ( step.kind == TokenKind::flag ) _flags.push_back(step.tok.name);
+            else if ( step.kind == TokenKind::value ) _values.emplace_back(step.owner, step.tok.name);
+            return step;
+        }
+        void scan_all() {
+            while ( !done() ) push();
+        }
+        bool scan_args(const int index) {
+            while ( _arguments.size() <= static_cast<size_t>(index) && !done() ) push();
+            return _arguments.size() > static_cast<size_t>(index);
+        }
+        [[nodiscard]] const detail::option_table::entry* find(const std::string& key) const {
+            return _state.options.find(key, _state.tokens.bytes);
+        }
+        std::optional<std::string_view> scan_first_value(const std::string& key) {
+            constexpr auto none = detail::Collector::none;
+            const auto* entry = find(key);
+            const std::uint32_t target = entry != nullptr ? _state.options.number(*entry) : none;
+            if ( target != none )
+                for (const auto& [owner, value] : _values)
+                    if ( owner == target ) return value;
+            std::uint32_t pending = target;
+            while ( !done() ) {
+                const auto step = push();
+                if ( pending == none && step.kind == TokenKind::option && step.tok.name == key )
+                    pending = step.owner;
+                else if ( pending != none && step.kind == TokenKind::value && step.owner == pending )
+                    return step.tok.name;
+            }
+            return std::nullopt;
+        }
+
+        int _argc;
+        char **_argv;
+        int _next = 0;
+        detail::Collector _state;
+        std::vector<std::string_view> _arguments = {}; // views into argv
+        std::vector<std::string_view> _flags = {};
+        std::vector<std::pair<std::uint32_t, std::string_view>> _values = {}; // entry and value, in order
+    };
+
+    namespace detail {
+        struct string_ref {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+        struct option_entry {
+            string_ref key;
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+        struct image_header {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint32_t size;
+            std::uint32_t arg_count;
+            std::uint32_t arg_table;
+            std::uint32_t opt_count;
+            std::uint32_t opt_table;
+            std::uint32_t value_count;
+            std::uint32_t value_table;
+            std::uint32_t flag_count;
+            std::uint32_t flag_table;
+            std::uint32_t blob;
+        };
+        inline constexpr std::uint32_t image_magic = 0x58475241; // "ARGX"
+        inline constexpr std::uint32_t image_version = 1;
+    }
+
+    /**
+     * Range of strings stored in a frozen image
+     */
+    class StringRange {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = std::string_view;
+
+            iterator() = default;
+            iterator(const detail::string_ref* ref, const char* blob): _ref(ref), _blob(blob) {}
+
+            std::string_view operator*() const { return {_blob + _ref->offset, _ref->length}; }
+            iterator& operator++() { ++_ref; return *this; }
+            iterator operator++(int) { auto it = *this; ++_ref; return it; }
+            bool operator==(const iterator& other) const { return _ref == other._ref; }
+        private:
+            const detail::string_ref* _ref = nullptr;
+            const char* _blob = nullptr;
+        };
+
+        StringRange() = default;
+        StringRange(const detail::string_ref* refs, const size_t count, const char* blob):
+        _refs(refs), _count(count), _blob(blob) {}
+
+        [[nodiscard]] iterator begin() const { return {_refs, _blob}; }
+        [[nodiscard]] iterator end() const { return {_refs + _count, _blob}; }
+        [[nodiscard]] size_t size() const { return _count; }
+        [[nodiscard]] bool empty() const { return _count == 0; }
+        [[nodiscard]] std::string_view operator[](const size_t index) const {
+            return {_blob + _refs[index].offset, _refs[index].length};
+        }
+    private:
+        const detail::string_ref* _refs = nullptr;
+        size_t _count = 0;
+        const char* _blob = nullptr;
+    };
+
+    /**
+     * Read-only view over a frozen result image
+     * The image only stores offsets relative to its own start,
+     * so it can be read wherever the bytes are mapped
+     */
+    class ResultView {
+    public:
+        ResultView() = default;
+        /**
+         * Attach to a frozen image
+         * @param image : start of the image, 4-byte aligned
+         * @param size : number of readable bytes
+         * @throw std::invalid_argument if the image is malformed
+         */
+        ResultView(const void* image, const size_t size): _base(static_cast<const char*>(image)) {
+            if ( size < sizeof(detail::image_header) || reinterpret_cast<std::uintptr_t>(image) % alignof(detail::image_header) != 0 )
+                ARGX_THROW(std::invalid_argument("argx:ResultView:Malformed image"));
+            const auto& h = header();
+            if ( h.magic != detail::image_magic || h.version != detail::image_version || h.size > size || h.blob > h.size )
+                ARGX_THROW(std::invalid_argument("argx:ResultView:Malformed image"));
+            const auto table_fits = [&](const std::uint32_t offset, const std::uint64_t count, const size_t entry) {
+                return offset % alignof(detail::image_header) == 0 && offset + count * entry <= h.blob;
+            };
+            if ( !table_fits(h.arg_table, h.arg_count, sizeof(detail::string_ref))
+                || !table_fits(h.opt_table, h.opt_count, sizeof(detail::option_entry))
+                || !table_fits(h.value_table, h.value_count, sizeof(detail::string_ref))
+                || !table_fits(h.flag_table, h.flag_count, sizeof(detail::string_ref)) )
+                ARGX_THROW(std::invalid_argument("argx:ResultView:Malformed image"));
+            const std::uint64_t blob_size = h.size - h.blob;
+            const auto ref_fits = [&](const detail::string_ref& ref) {
+                return std::uint64_t(ref.offset) + ref.length <= blob_size;
+            };
+            for (const auto& ref : args_table()) if (!ref_fits(ref)) ARGX_THROW(std::invalid_argument("argx:ResultView:Malformed image"));
+            for (const auto& ref : values_table()) if (!ref_fits(ref)) ARGX_THROW(std::invalid_argument("argx:ResultView:Malformed image"));
+            for (const auto& ref : flags_table()) if (!ref_fits(ref)) ARGX_THROW(std::invalid_argument("argx:ResultView:Malformed image"));
+            for (const auto& entry : options_table())
+                if ( !ref_fits(entry.key) || std::uint64_t(entry.first) + entry.count > h.value_count )
+                    ARGX_THROW(std::invalid_argument("argx:ResultView:Malformed image"));
+        }
+
+        /**
+         * Get the raw bytes of the image
+         * @return pointer to the start of the image
+         */
+        [[nodiscard]] const void* data() const { return _base; }
+        /**
+         * Get the size of the image in bytes
+         * @return size of the image
+         */
+        [[nodiscard]] size_t size() const { return _base ? header().size : 0; }
+
+        /**
+         * Get the size of arguments
+         * @return size of arguments
+         */
+        [[nodiscard]] size_t arg_size() const { return _base ? header().arg_count : 0; }
+        /**
+         * Get the argument at the index or return the default value
+         * @param index : index of the argument
+         * @param def : default value
+         * @return argument at the index or default value
+         */
+        [[nodiscard]] std::string_view arg_or_def(const int index, const std::string_view def) const {
+            if ( index < 0 || static_cast<size_t>(index) >= arg_size() ) return def;
+            return args()[index];
+        }
+        /**
+         * Get the argument at the index
+         * @param index : index of the argument
+         * @return argument at the index
+         * @throw std::out_of_range if index is out of range
+         */
+        [[nodiscard]] std::string_view argument(const int index) const {
+            if ( index < 0 || static_cast<size_t>(index) >= arg_size() ) ARGX_THROW(std::out_of_range("argx:ResultView:Index out of range:"+std::to_string(index)));
+            return args()[index];
+        }
+        /**
+         * Get the list of arguments
+         * @return range of arguments
+         */
+        [[nodiscard]] StringRange args() const {
+            return {args_table().data(), args_table().size(), blob()};
+        }
+
+        /**
+         * Get the size of options
+         * @return size of options
+         */
+        [[nodiscard]] size_t option_size() const { return _base ? header().opt_count : 0; }
+        /**
+         * Check if the option exists
+         * @param key : key of the option
+         * @return true if the option exists
+         */
+        [[nodiscard]] bool contains(const std::string_view key) const { return find(key) != nullptr; }
+        /**
+         * Get the option value of the key or return the default value
+         * @param key : key of the option
+         * @param def : default value
+         * @return option value of the key or default value
+         */
+        [[nodiscard]] std::string_view option_or_def(const std::string_view key, const std::string_view def) const {
+            const auto* entry = find(key);
+            if ( entry == nullptr || entry->count == 0 ) return def;
+            return value(entry->first);
+        }
+        /**
+         * Get the option value of the key
+         * @param key : key of the option
+         * @return option value of the key
+         * @throw std::out_of_range if key is not found
+         */
+        [[nodiscard]] std::string_view option(const std::string_view key) const {
+            const auto* entry = find(key);
+            if ( entry == nullptr || entry->count == 0 ) ARGX_THROW(std::out_of_range("argx:ResultView:Key not found"));
+            return value(entry->first);
+        }
+        /**
+         * Get the option value of the key or return the default value
+         * @param keys : list of keys
+         * @param def : default value
+         * @return option value of the key or default value
+         */
+        [[nodiscard]] std::string_view option_or_def(const string_il keys, const std::string_view def) const {
+            for(const auto& key : keys) {
+                const auto* entry = find(key);
+                if ( entry != nullptr && entry->count != 0 ) return value(entry->first);
+            }
+            return def;
+        }
+        /**
+         * Get the option value of the key
+         * @param keys : list of keys
+         * @return option value of the key
+         * @throw std::out_of_range if key is not found
+         */
+        [[nodiscard]] std::string_view option(const string_il keys) const {
+            for(const auto& key : keys) {
+                const auto* entry = find(key);
+                if ( entry != nullptr && entry->count != 0 ) return value(entry->first);
+            }
+            ARGX_THROW(std::out_of_range("argx:ResultView:Key not found"));
+        }
+        /**
+         * Get the list of options
+         * @param key : key of the option
+         * @return range of option values
+         */
+        [[nodiscard]] StringRange options(const std::string_view key) const {
+            const auto* entry = find(key);
+            if ( entry == nullptr ) return {};
+            return {values_table().data() + entry->first, entry->count, blob()};
+        }
+        /**
+         * Convert the option value into a list of numbers
+         * @param key : key of the option
+         * @param delimiter : separator between numbers
+         * @return numbers of the first value, empty if the option has no value
+         * @throw std::invalid_argument if an element is not a number of type T
+         */
+        template <typename T>
+        [[nodiscard]] std::vector<T> option_list(const std::string_view key, const char delimiter = ',') const {
+            const auto* entry = find(key);
+            if ( entry == nullptr || entry->count == 0 ) return {};
+            return parse_list<T>(value(entry->first), delimiter);
+        }
+        /**
+         * Parse the option value as a range expression
+         * @param key : key of the option
+         * @return range expression, empty if the option has no value
+         * @throw std::invalid_argument if the expression is malformed
+         */
+        [[nodiscard]] RangeExpr option_range(const std::string_view key) const {
+            const auto* entry = find(key);
+            if ( entry == nullptr || entry->count == 0 ) return {};
+            return RangeExpr(value(entry->first));
+        }
+
+        /**
+         * Get the size of flags
+         * @return size of flags
+         */
+        [[nodiscard]] size_t flag_size() const { return _base ? header().flag_count : 0; }
+        /**
+         * Check if the flag exists
+         * @param flag : flag to check
+         * @return true if the flag exists
+         */
+        [[nodiscard]] bool flag(const std::string_view flag) const {
+            const StringRange range = flags();
+            return std::ranges::find(range, flag) != range.end();
+        }
+        /**
+         * Get the list of flags
+         * @return range of flags
+         */
+        [[nodiscard]] StringRange flags() const {
+            return {flags_table().data(), flags_table().size(), blob()};
+        }
+
+        /**
+         * Copy the image back into a mutable ParseResult
+         * @return parse result holding the same values
+         */
+        [[nodiscard]] ParseResult to_result() const {
+            string_list arguments(args().begin(), args().end());
+            options_map options = {};
+            for (const auto& entry : options_table()) {
+                const StringRange values = {values_table().data() + entry.first, entry.count, blob()};
+                options.emplace(std::string(blob() + entry.key.offset, entry.key.length), string_list(values.begin(), values.end()));
+            }
+            string_list flag_list(flags().begin(), flags().end());
+            return {arguments, options, flag_list};
+        }
+    private:
+        [[nodiscard]] const detail::image_header& header() const {
+            return *reinterpret_cast<const detail::image_header*>(_base);
+        }
+        [[nodiscard]] const char* blob() const { return _base + header().blob; }
+        template <typename T>
+        [[nodiscard]] std::span<const T> table(const std::uint32_t offset, const std::uint32_t count) const {
+            if ( _base == nullptr ) return {};
+            return {reinterpret_cast<const T*>(_base + offset), count};
+        }
+        [[nodiscard]] std::span<const detail::string_ref> args_table() const {
+            return _base ? table<detail::string_ref>(header().arg_table, header().arg_count) : std::span<const detail::string_ref>{};
+        }
+        [[nodiscard]] std::span<const detail::option_entry> options_table() const {
+            return _base ? table<detail::option_entry>(header().opt_table, header().opt_count) : std::span<const detail::option_entry>{};
+        }
+        [[nodiscard]] std::span<const detail::string_ref> values_table() const {
+            return _base ? table<detail::string_ref>(header().value_table, header().value_count) : std::span<const detail::string_ref>{};
+        }
+        [[nodiscard]] std::span<const detail::string_ref> flags_table() const {
+            return _base ? table<detail::string_ref>(header().flag_table, header().flag_count) : std::span<const detail::string_ref>{};
+        }
+        [[nodiscard]] std::string_view value(const std::uint32_t index) const {
+            const auto& ref = values_table()[index];
+            return {blob() + ref.offset, ref.length};
+        }
+        [[nodiscard]] const detail::option_entry* find(const std::string_view key) const {
+            const auto entries = options_table();
+            const auto it = std::ranges::lower_bound(entries, key, {}, [&](const detail::option_entry& entry) {
+                return std::string_view(blob() + entry.key.offset, entry.key.length);
+            });
+            if ( it == entries.end() || std::string_view(blob() + it->key.offset, it->key.length) != key ) return nullptr;
+            return &*it;
+        }
+
+        const char* _base = nullptr;
+    };
+
+    /**
+     * Owning frozen result
+     * Copies share the same immutable image. Nothing in a frozen result
+     * is ever written after argx::freeze returns, so it can be shared
+     * between any number of threads and read without locking.
+     */
+    class FrozenResult : public ResultView {
+    public:
+        FrozenResult() = default;
+        FrozenResult(std::shared_ptr<const std::uint32_t[]> image, const size_t size):
+        ResultView(image.get(), size), _image(std::move(image)) {}
+    private:
+        std::shared_ptr<const std::uint32_t[]> _image;
+    };
+
+    /**
+     * Freeze a parse result into a flat, position independent image
+     * @param result : result to freeze
+     * @return frozen result
+     * @throw std::length_error if the image would exceed 4 GiB
+     */
+    inline FrozenResult freeze(const ParseResult& result) {
+        const string_list arguments = result.args();
+        const options_map options = result.options();
+        const string_list flags = result.flags();
+
+        size_t value_count = 0;
+        size_t blob_size = 0;
+        for (const auto& argument : arguments) blob_size += argument.size();
+        for (const auto& [key, values] : options) {
+            blob_size += key.size();
+            value_count += values.size();
+            for (const auto& value : values) blob_size += value.size();
+        }
+        for (const auto& flag : flags) blob_size += flag.size();
+
+        detail::image_header h = {};
+        h.magic = detail::image_magic;
+        h.version = detail::image_version;
+        size_t offset = sizeof(detail::image_header);
+        h.arg_table = offset;
+        offset += arguments.size() * sizeof(detail::string_ref);
+        h.opt_table = offset;
+        offset += options.size() * sizeof(detail::option_entry);
+        h.value_table = offset;
+        offset += value_count * sizeof(detail::string_ref);
+        h.flag_table = offset;
+        offset += flags.size() * sizeof(detail::string_ref);
+        h.blob = offset;
+        const size_t total = offset + blob_size;
+        if ( total > UINT32_MAX ) ARGX_THROW(std::length_error("argx:freeze:Image too large"));
+        h.size = total;
+        h.arg_count = arguments.size();
+        h.opt_count = options.size();
+        h.value_count = value_count;
+        h.flag_count = flags.size();
+
+        const size_t words = (total + sizeof(std::uint32_t) - 1) / sizeof(std::uint32_t);
+        std::shared_ptr<std::uint32_t[]> image = std::make_shared<std::uint32_t[]>(words);
+        auto* base = reinterpret_cast<char*>(image.get());
+        std::memcpy(base, &h, sizeof(h));
 
-    class ParseResult {
+        std::uint32_t cursor = 0;
+        const auto put = [&](const std::string& text) {
+            std::memcpy(base + h.blob + cursor, text.data(), text.size());
+            const detail::string_ref ref = {cursor, static_cast<std::uint32_t>(text.size())};
+            cursor += text.size();
+            return ref;
+        };
+        auto* arg_table = reinterpret_cast<detail::string_ref*>(base + h.arg_table);
+        for (const auto& argument : arguments) *arg_table++ = put(argument);
+        auto* opt_table = reinterpret_cast<detail::option_entry*>(base + h.opt_table);
+        auto* value_table = reinterpret_cast<detail::string_ref*>(base + h.value_table);
+        std::uint32_t first = 0;
+        for (const auto& [key, values] : options) {
+            *opt_table++ = {put(key), first, static_cast<std::uint32_t>(values.size())};
+            for (const auto& value : values) *value_table++ = put(value);
+            first += values.size();
+        }
+        auto* flag_table = reinterpret_cast<detail::string_ref*>(base + h.flag_table);
+        for (const auto& flag : flags) *flag_table++ = put(flag);
+
+        return {std::move(image), total};
+    }
+
+    /**
+     * One row of a help text: the option column and its description
+     */
+    struct HelpLine {
+        std::string_view left;
+        std::string_view help;
+    };
+
+    namespace detail {
+        /**
+         * Format help lines, wrapping descriptions to the width in one pass
+         * Usable at compile time, put receives every piece of output text.
+         */
+        template <typename Put>
+        constexpr void format_help(const std::span<const HelpLine> lines, const size_t width, Put&& put) {
+            constexpr std::string_view spaces = "                                ";
+            const auto pad = [&](size_t count) {
+                while ( count > 0 ) {
+                    const size_t chunk = std::min(count, spaces.size());
+                    put(spaces.substr(0, chunk));
+                    count -= chunk;
+                }
+            };
+            size_t left = 0;
+            for (const auto& line : lines) left = std::max(left, line.left.size());
+            const size_t indent = std::min(left + 4, std::max<size_t>(width / 2, 8));
+
+            for (const auto& line : lines) {
+                put("  ");
+                put(line.left);
+                size_t column = 2 + line.left.size();
+                if ( !line.help.empty() ) {
+                    if ( column + 2 > indent ) {
+                        put("\n");
+                        column = 0;
+                    }
+                    pad(indent - column);
+                    column = indent;
+                    bool first = true;
+                    std::string_view rest = line.help;
+                    while ( !rest.empty() ) {
+                        const size_t space = std::min(rest.find(' '), rest.size());
+                        const std::string_view word = rest.substr(0, space);
+                        rest.remove_prefix(std::min(space + 1, rest.size()));
+                        if ( word.empty() ) continue;
+                        if ( !first && column + 1 + word.size() > width ) {
+                            put("\n");
+                            pad(indent);
+                            column = indent;
+                            first = true;
+                        }
+                        if ( !first ) {
+                            put(" ");
+                            column++;
+                        }
+                        put(word);
+                        column += word.size();
+                        first = false;
+                    }
+                }
+                put("\n");
+            }
+        }
+    }
+
+    /**
+     * Help text stored in a static, fixed size buffer
+     */
+    template <size_t N>
+    struct StaticText {
+        std::array<char, N + 1> data = {};
+        [[nodiscard]] constexpr std::string_view view() const { return {data.data(), N}; }
+        [[nodiscard]] constexpr const char* c_str() const { return data.data(); }
+    };
+
+    /**
+     * Format help text at compile time
+     * Example:
+     *     constexpr auto help = argx::static_help<80>([] { return std::array{
+     *         argx::HelpLine{"-t, -threads <N>", "Number of worker threads"},
+     *         argx::HelpLine{"--help", "Print this help"},
+     *     }; });
+     * @param spec : captureless lambda returning an array of HelpLine
+     * @return text of the help
+     */
+    template <size_t Width = 80, typename F>
+    consteval auto static_help(F) {
+        constexpr auto lines = F{}();
+        constexpr size_t size = [&] {
+            size_t count = 0;
+            detail::format_help(lines, Width, [&](const std::string_view text) { count += text.size(); });
+            return count;
+        }();
+        StaticText<size> out = {};
+        size_t cursor = 0;
+        detail::format_help(lines, Width, [&](const std::string_view text) {
+            for (const char c : text) out.data[cursor++] = c;
+        });
+        return out;
+    }
+
+    /**
+     * Get the width of the terminal attached to stdout
+     * @return number of columns, COLUMNS or 80 if unknown
+     */
+    inline size_t terminal_width() {
+#if defined(__unix__) || defined(__APPLE__)
+        winsize size = {};
+        if ( ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 ) return size.ws_col;
+#endif
+        if ( const char* columns = std::getenv("COLUMNS") ) {
+            size_t width = 0;
+            const std::string_view text = columns;
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), width);
+            if ( error == std::errc() && width > 0 ) return width;
+        }
+        return 80;
+    }
+
+    /**
+     * Help text generated from a schema on demand
+     * Nothing is formatted until text() is called, the option column is
+     * built once and the wrapped text is cached for the last width.
+     * The layout refers into the schema and into its own storage, it is rebuilt
+     * whenever the revision of the schema changed since, so options added or
+     * described after the first text() are picked up. A help is neither copied nor moved.
+     */
+    class Help {
     public:
-        ParseResult(string_list args, options_map options, string_list flags):
-        _args(std::move(args)), _opts(std::move(options)), _flags(std::move(flags)) {}
+        /**
+         * @param schema : schema to describe, must outlive the help
+         * @param usage : text printed above the options, e.g. "Usage: tool [options] files..."
+         */
+        explicit Help(const Schema& schema, std::string usage = {}): _schema(&schema), _usage(std::move(usage)) {}
+        Help(const Help&) = delete;
+        Help& operator=(const Help&) = delete;
 
         /**
-         * Get the size of arguments
-         * @return size of arguments
+         * Get the help text wrapped to a width
+         * @param width : number of columns
+         * @return help text
          */
-        [[nodiscard]] size_t arg_size() const { return _args.size(); }
+        [[nodiscard]] const std::string& text(const size_t width) {
+            if ( _revision != _schema->revision() ) {
+                layout();
+                _revision = _schema->revision();
+                _formatted = false;
+            }
+            if ( _formatted && width == _width ) return _text;
+            _text.clear();
+            if ( !_usage.empty() ) {
+                _text += _usage;
+                _text += "\n\n";
+            }
+            detail::format_help(_lines, width, [&](const std::string_view text) { _text += text; });
+            _width = width;
+            _formatted = true;
+            return _text;
+        }
         /**
-         * Get the argument at the index or return the default value
-         * @param index : index of the argument
-         * @param def : default value
-         * @return argument at the index or default value
+         * Get the help text wrapped to the terminal width
+         * @return help text
          */
-        [[nodiscard]] std::string arg_or_def(const int index, const std::string& def) {
-            if ( index >= _args.size() ) return def;
-            auto it = _args.begin();
-            std::advance(it, index);
-            return *it;
+        [[nodiscard]] const std::string& text() { return text(terminal_width()); }
+    private:
+        void layout() {
+            _left.clear();
+            _lines.clear();
+            _left.reserve(_schema->size());
+            for (size_t i = 0; i < _schema->size(); i++) {
+                const auto id = static_cast<option_id>(i);
+                std::string left = {};
+                for (const auto& alias : _schema->aliases(id)) {
+                    if ( !left.empty() ) left += ", ";
+                    left += _schema->is_flag(id) ? "--" : "-";
+                    left += alias;
+                }
+                if ( !_schema->value_name(id).empty() ) left += " <" + _schema->value_name(id) + ">";
+                _left.push_back(std::move(left));
+            }
+            _lines.reserve(_left.size());
+            for (size_t i = 0; i < _left.size(); i++)
+                _lines.push_back({_left[i], _schema->help(static_cast<option_id>(i))});
+        }
+
+        const Schema* _schema;
+        std::string _usage;
+        std::vector<std::string> _left = {};
+        std::vector<HelpLine> _lines = {};
+        std::string _text = {};
+        size_t _width = 0;
+        std::uint64_t _revision = UINT64_MAX; // revision of the schema the layout was built from
+        bool _formatted = false;
+    };
+
+    /**
+     * Process wide registry of the command line
+     * main publishes a frozen result once, any thread reads it afterwards
+     * through an atomic pointer without locking. Libraries declare the
+     * options they read as static Option or Flag objects, which are
+     * collected into one schema.
+     */
+    namespace global {
+        class Declaration;
+    }
+
+    namespace detail {
+        inline constinit std::atomic<global::Declaration*> global_declarations{nullptr};
+        inline constinit std::mutex global_declarations_mutex; // serializes linking and unlinking
+        inline constinit std::atomic<const FrozenResult*> global_result{nullptr};
+    }
+
+    namespace global {
+        /**
+         * Option or flag declared by library code
+         * Construction only links the object into an intrusive list under a
+         * constinit mutex, so declarations do not depend on static initialization
+         * order. Destruction unlinks it again under the same mutex, so declarations
+         * with automatic storage or in unloaded libraries leave no dangling node.
+         * Walking the registry takes no lock, so a declaration must not be
+         * destroyed while another thread walks it.
+         */
+        class Declaration {
+        public:
+            Declaration(const Declaration&) = delete;
+            Declaration& operator=(const Declaration&) = delete;
+
+            /**
+             * Get the comma separated aliases
+             * @return aliases as declared
+             */
+            [[nodiscard]] std::string_view aliases() const { return _aliases; }
+            /**
+             * Get the canonical name
+             * @return first alias
+             */
+            [[nodiscard]] std::string_view name() const { return _aliases.substr(0, _aliases.find(',')); }
+            /**
+             * Get the help text
+             * @return help text as declared
+             */
+            [[nodiscard]] std::string_view help() const { return _help; }
+            /**
+             * Check if the declaration is a flag
+             * @return true for flags, false for options
+             */
+            [[nodiscard]] bool is_flag() const { return _flag; }
+            /**
+             * Get the next declaration of the registry
+             * @return next declaration or nullptr
+             */
+            [[nodiscard]] const Declaration* next() const { return _next.load(std::memory_order_acquire); }
+        protected:
+            /**
+             * @throw std::system_error if the registry mutex cannot be locked
+             */
+            Declaration(const std::string_view aliases, const std::string_view help, const bool flag):
+            _aliases(aliases), _help(help), _flag(flag) {
+                std::lock_guard lock(detail::global_declarations_mutex);
+                _next.store(detail::global_declarations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                detail::global_declarations.store(this, std::memory_order_release);
+            }
+            ~Declaration() {
+                std::lock_guard lock(detail::global_declarations_mutex);
+                std::atomic<Declaration*>* link = &detail::global_declarations;
+                for (Declaration* current = link->load(std::memory_order_relaxed); current; current = link->load(std::memory_order_relaxed)) {
+                    if ( current == this ) {
+                        link->store(_next.load(std::memory_order_relaxed), std::memory_order_release);
+                        return;
+                    }
+                    link = &current->_next;
+                }
+            }
+        private:
+            std::string_view _aliases;
+            std::string_view _help;
+            bool _flag;
+            std::atomic<Declaration*> _next = nullptr;
+        };
+
+        /**
+         * Get the first declaration of the registry
+         * @return first declaration or nullptr
+         */
+        inline const Declaration* declarations() {
+            return detail::global_declarations.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Get the schema of every declared option and flag
+         * It is built on the first call, later declarations are not included.
+         * @return schema of the registry
+         * @throw std::invalid_argument if two declarations share an alias
+         */
+        inline const Schema& schema() {
+            static const Schema table = [] {
+                Schema schema;
+                for (const Declaration* declaration = declarations(); declaration; declaration = declaration->next()) {
+                    std::vector<std::string> aliases = {};
+                    std::string_view rest = declaration->aliases();
+                    while ( !rest.empty() ) {
+                        const size_t comma = std::min(rest.find(','), rest.size());
+                        if ( comma != 0 ) aliases.emplace_back(rest.substr(0, comma));
+                        rest.remove_prefix(std::min(comma + 1, rest.size()));
+                    }
+                    const option_id id = declaration->is_flag() ? schema.add_flag(aliases) : schema.add(aliases);
+                    schema.help(id, std::string(declaration->help()));
+                }
+                return schema;
+            }();
+            return table;
+        }
+
+        /**
+         * Publish the result of the process, exactly once
+         * @param result : frozen result to publish
+         * @throw std::logic_error if a result was already published
+         */
+        inline void publish(FrozenResult result) {
+            auto owned = std::make_unique<const FrozenResult>(std::move(result));
+            const FrozenResult* expected = nullptr;
+            if ( !detail::global_result.compare_exchange_strong(expected, owned.get(), std::memory_order_release, std::memory_order_relaxed) )
+                ARGX_THROW(std::logic_error("argx:global:Result already published"));
+            owned.release(); // Lives until process exit, readers may hold views into it
+        }
+        /**
+         * Parse with the registry schema and publish the result
+         * @param argc : number of arguments
+         * @param argv : arguments
+         * @throw std::logic_error if a result was already published
+         */
+        inline void publish(const int argc, char **argv) {
+            publish(freeze(parse(schema(), argc, argv)));
         }
+        /**
+         * Get the published result
+         * @return published result or nullptr if nothing was published yet
+         */
+        inline const FrozenResult* result() {
+            return detail::global_result.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Option declared by library code
+         * Example:
+         *     static argx::global::Option threads("threads,t", "Number of worker threads");
+         */
+        class Option : public Declaration {
+        public:
+            /**
+             * @param aliases : comma separated aliases, the first one is the canonical name
+             * @param help : help text
+             */
+            Option(const std::string_view aliases, const std::string_view help = {}):
+            Declaration(aliases, help, false) {}
+
+            /**
+             * Check if the option exists in the published result
+             * @return true if the option exists
+             */
+            [[nodiscard]] bool present() const {
+                const FrozenResult* published = result();
+                return published != nullptr && published->contains(name());
+            }
+            /**
+             * Get the option value or return the default value
+             * @param def : default value
+             * @return option value or default value
+             */
+            [[nodiscard]] std::string_view value_or(const std::string_view def) const {
+                const FrozenResult* published = result();
+                return published != nullptr ? published->option_or_def(name(), def) : def;
+            }
+            /**
+             * Get the option value
+             * @return option value
+             * @throw std::out_of_range if nothing was published or the option has no value
+             */
+            [[nodiscard]] std::string_view value() const {
+                const FrozenResult* published = result();
+                if ( published == nullptr ) ARGX_THROW(std::out_of_range("argx:global:Nothing published"));
+                return published->option(name());
+            }
+            /**
+             * Get every value of the option
+             * @return range of option values
+             */
+            [[nodiscard]] StringRange values() const {
+                const FrozenResult* published = result();
+                return published != nullptr ? published->options(name()) : StringRange{};
+            }
+        };
+
+        /**
+         * Flag declared by library code
+         * Example:
+         *     static argx::global::Flag verbose("verbose,v", "Print more details");
+         */
+        class Flag : public Declaration {
+        public:
+            /**
+             * @param aliases : comma separated aliases, the first one is the canonical name
+             * @param help : help text
+             */
+            Flag(const std::string_view aliases, const std::string_view help = {}):
+            Declaration(aliases, help, true) {}
+
+            /**
+             * Check if the flag exists in the published result
+             * @return true if the flag exists
+             */
+            [[nodiscard]] bool present() const {
+                const FrozenResult* published = result();
+                return published != nullptr && published->flag(name());
+            }
+            explicit operator bool() const { return present(); }
+        };
+    }
+
+    /**
+     * Merge two results, values in the overrides win
+     * Options of the overrides replace the same key of the base, flags are
+     * combined, and the arguments of the overrides replace the base arguments
+     * unless there are none.
+     * @param base : lower priority result, e.g. from a config file
+     * @param overrides : higher priority result, e.g. from argv
+     * @return merged result
+     */
+    inline ParseResult merge(const ParseResult& base, const ParseResult& overrides) {
+        options_map options = overrides.options();
+        options.merge(base.options()); // Keeps the keys already present
+        string_list flags = base.flags();
+        for (auto& flag : overrides.flags())
+            if ( std::ranges::find(flags, flag) == flags.end() ) flags.push_back(std::move(flag));
+        return {overrides.arg_size() != 0 ? overrides.args() : base.args(), std::move(options), std::move(flags)};
+    }
+
+    /**
+     * Result of argx::parse_literal, with fixed capacity and usable in constant expressions
+     * Every value is a view into the literal it was parsed from.
+     */
+    template <size_t Capacity>
+    class LiteralResult {
+    public:
+        constexpr LiteralResult() = default;
+
+        /**
+         * Get the size of arguments
+         * @return size of arguments
+         */
+        [[nodiscard]] constexpr size_t arg_size() const { return _arg_size; }
         /**
          * Get the argument at the index
          * @param index : index of the argument
          * @return argument at the index
          * @throw std::out_of_range if index is out of range
          */
-        [[nodiscard]] std::string argument(const int index) {
-            if ( index >= _args.size() ) throw std::out_of_range("argx:ParseResult:Index out of range:"+std::to_string(index));
-            auto it = _args.begin();
-            std::advance(it, index);
-            return *it;
+        [[nodiscard]] constexpr std::string_view argument(const size_t index) const {
+            if ( index >= _arg_size ) ARGX_THROW(std::out_of_range("argx:LiteralResult:Index out of range"));
+            return _args[index];
         }
         /**
-         * Get the list of arguments
-         * @return list of arguments
+         * Get the size of flags
+         * @return size of flags
          */
-        [[nodiscard]] string_list args() const { return _args; }
-
+        [[nodiscard]] constexpr size_t flag_size() const { return _flag_size; }
         /**
-         * Get the size of options
-         * @return size of options
+         * Check if the flag exists
+         * @param name : name of the flag
+         * @return true if the flag exists
          */
-        [[nodiscard]] size_t option_size() const { return _opts.size(); }
+        [[nodiscard]] constexpr bool flag(const std::string_view name) const {
+            for (size_t i = 0; i < _flag_size; i++)
+                if ( _flags[i] == name ) return true;
+            return false;
+        }
         /**
-         * Get the option value of the key or return the default value
+         * Check if the option exists
+         * @param key : key of the option
+         * @return true if the option exists
+         */
+        [[nodiscard]] constexpr bool contains(const std::string_view key) const {
+            for (size_t i = 0; i < _option_size; i++)
+                if ( _keys[i] == key ) return true;
+            return false;
+        }
+        /**
+         * Get the first option value of the key or return the default value
          * @param key : key of the option
          * @param def : default value
          * @return option value of the key or default value
          */
-        [[nodiscard]] std::string option_or_def(const std::string& key, const std::string& def) {
-            if(_opts.contains(key)) {
-                return _opts[key].front();
-            }
+        [[nodiscard]] constexpr std::string_view option_or_def(const std::string_view key, const std::string_view def) const {
+            for (size_t i = 0; i < _option_size; i++)
+                if ( _keys[i] == key && _valued[i] ) return _values[i];
             return def;
         }
         /**
-         * Get the option value of the key
+         * Get the first option value of the key
          * @param key : key of the option
          * @return option value of the key
          * @throw std::out_of_range if key is not found
          */
-        [[nodiscard]] std::string option(std::string key) {
-            return option({std::move(key)});
+        [[nodiscard]] constexpr std::string_view option(const std::string_view key) const {
+            for (size_t i = 0; i < _option_size; i++)
+                if ( _keys[i] == key && _valued[i] ) return _values[i];
+            ARGX_THROW(std::out_of_range("argx:LiteralResult:Key not found"));
         }
         /**
-         * Get the option value of the key or return the default value
-         * @param keys : list of keys
+         * Convert into a runtime result
+         * @return result holding copies of every value
+         */
+        [[nodiscard]] ParseResult to_result() const {
+            string_list args = {}, flags = {};
+            options_map options = {};
+            for (size_t i = 0; i < _arg_size; i++) args.emplace_back(_args[i]);
+            for (size_t i = 0; i < _flag_size; i++) flags.emplace_back(_flags[i]);
+            for (size_t i = 0; i < _option_size; i++) {
+                auto& values = options[std::string(_keys[i])];
+                if ( _valued[i] ) values.emplace_back(_values[i]);
+            }
+            return {std::move(args), std::move(options), std::move(flags)};
+        }
+
+    private:
+        template <size_t N>
+        friend constexpr LiteralResult<N / 2 + 1> parse_literal(const char (&text)[N]);
+        template <size_t N>
+        friend ParseResult merge(const LiteralResult<N>& defaults, const ParseResult& overrides);
+
+        std::array<std::string_view, Capacity> _args = {};
+        std::array<std::string_view, Capacity> _flags = {};
+        std::array<std::string_view, Capacity> _keys = {};
+        std::array<std::string_view, Capacity> _values = {};
+        std::array<bool, Capacity> _valued = {};
+        size_t _arg_size = 0;
+        size_t _flag_size = 0;
+        size_t _option_size = 0;
+    };
+
+    /**
+     * Parse a command line literal, in a constant expression if needed
+     * Tokens are separated by whitespace, "double quotes" group a token
+     * without escapes. Tokens are classified exactly like argx::parse.
+     * @param text : command line, e.g. "-threads 8 --fast in.txt"
+     * @return fixed capacity result viewing into text
+     * @throw std::invalid_argument if a quote is not closed
+     */
+    template <size_t N>
+    constexpr LiteralResult<N / 2 + 1> parse_literal(const char (&text)[N]) {
+        LiteralResult<N / 2 + 1> result;
+        const std::string_view line(text, N - 1);
+        bool after_option = false;
+        size_t i = 0;
+        while (i < line.size()) {
+            if ( line[i] == ' ' || line[i] == '\t' || line[i] == '\n' ) { i++; continue; }
+            std::string_view word;
+            if ( line[i] == '"' ) {
+                const size_t end = line.find('"', i + 1);
+                if ( end == std::string_view::npos ) ARGX_THROW(std::invalid_argument("argx:parse_literal:Unterminated quote"));
+                word = line.substr(i + 1, end - i - 1);
+                i = end + 1;
+            } else {
+                const size_t end = std::min(line.find_first_of(" \t\n", i), line.size());
+                word = line.substr(i, end - i);
+                i = end;
+            }
+            const auto tok = detail::classify(word);
+            switch (tok.kind) {
+                case detail::token_kind::flag:
+                    after_option = false;
+                    result._flags[result._flag_size++] = tok.name;
+                    break;
+                case detail::token_kind::option:
+                    after_option = true;
+                    result._keys[result._option_size++] = tok.name;
+                    break;
+                case detail::token_kind::argument:
+                    if ( after_option ) {
+                        result._values[result._option_size - 1] = tok.name;
+                        result._valued[result._option_size - 1] = true;
+                        after_option = false;
+                    } else {
+                        result._args[result._arg_size++] = tok.name;
+                    }
+                    break;
+                case detail::token_kind::none:
+                    break;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Merge compile time defaults under a runtime result
+     * Follows the rules of argx::merge, but collects straight from the views of
+     * both results: no intermediate result or container is built, only the merged one.
+     * @param defaults : result of argx::parse_literal
+     * @param overrides : higher priority result, e.g. from argv
+     * @return merged result
+     */
+    template <size_t Capacity>
+    ParseResult merge(const LiteralResult<Capacity>& defaults, const ParseResult& overrides) {
+        detail::Collector collector;
+        std::uint32_t index = 0;
+        const TokenRange tokens = overrides.tokens();
+        if ( overrides.arg_size() != 0 ) {
+            for (const Token token : tokens)
+                if ( token.kind == TokenKind::argument ) collector.argument(token.value, index++);
+        } else {
+            for (size_t i = 0; i < defaults._arg_size; i++) collector.argument(defaults._args[i], index++);
+        }
+        for (const auto& [key, values] : overrides.options_as_given()) {
+            if ( values.empty() ) collector.option(key, index++);
+            for (const std::string_view value : values) {
+                collector.option(key, index++);
+                collector.argument(value, index++);
+            }
+        }
+        const size_t overridden = collector.options.size(); // Entries below replace the defaults of their key
+        for (size_t i = 0; i < defaults._option_size; i++) {
+            const auto* entry = collector.options.find(defaults._keys[i], collector.tokens.bytes);
+            if ( entry != nullptr && collector.options.number(*entry) < overridden ) continue;
+            collector.option(defaults._keys[i], index++);
+            if ( defaults._valued[i] ) collector.argument(defaults._values[i], index++);
+        }
+        for (size_t i = 0; i < defaults._flag_size; i++) collector.flag(defaults._flags[i], index++);
+        for (auto it = tokens.begin(); it != tokens.end(); ++it) {
+            const Token token = *it;
+            if ( token.kind != TokenKind::flag || defaults.flag(token.key) ) continue;
+            const bool repeated = std::any_of(tokens.begin(), it, [&](const Token earlier) {
+                return earlier.kind == TokenKind::flag && earlier.key == token.key;
+            });
+            if ( !repeated ) collector.flag(token.key, index++);
+        }
+        return collector.finish();
+    }
+
+    /**
+     * Stack of results where upper layers override lower ones
+     * Example: defaults, config file, environment, command line
+     * Layers are shared and never copied: copying the stack copies
+     * references, so pushing per-request overrides onto a copy of a shared
+     * base costs only the overrides. Lookups follow the rules of argx::merge.
+     */
+    class LayeredResult {
+    public:
+        LayeredResult() = default;
+
+        /**
+         * Push a layer on top
+         * @param layer : result overriding every layer below
+         * @return this stack
+         */
+        LayeredResult& push(ParseResult layer) {
+            return push(std::make_shared<const ParseResult>(std::move(layer)));
+        }
+        /**
+         * Push a shared layer on top
+         * @param layer : result overriding every layer below
+         * @return this stack
+         */
+        LayeredResult& push(std::shared_ptr<const ParseResult> layer) {
+            if ( layer == nullptr ) ARGX_THROW(std::invalid_argument("argx:LayeredResult:Null layer"));
+            _layers.push_back(std::move(layer));
+            _cache = std::make_shared<cache>();
+            return *this;
+        }
+        /**
+         * Get the number of layers
+         * @return number of layers
+         */
+        [[nodiscard]] size_t layer_size() const { return _layers.size(); }
+        /**
+         * Get a layer
+         * @param index : index of the layer, 0 is the bottom
+         * @return shared layer
+         * @throw std::out_of_range if index is out of range
+         */
+        [[nodiscard]] const std::shared_ptr<const ParseResult>& layer(const size_t index) const {
+            if ( index >= _layers.size() ) ARGX_THROW(std::out_of_range("argx:LayeredResult:Index out of range:"+std::to_string(index)));
+            return _layers[index];
+        }
+
+        /**
+         * Get the arguments of the topmost layer that has any
+         * @return list of arguments
+         */
+        [[nodiscard]] string_list args() const {
+            for (auto it = _layers.rbegin(); it != _layers.rend(); ++it)
+                if ( (*it)->arg_size() != 0 ) return (*it)->args();
+            return {};
+        }
+        /**
+         * Check if any layer has the option
+         * @param key : key of the option
+         * @return true if the option exists
+         */
+        [[nodiscard]] bool contains(const std::string& key) const { return top(key) != nullptr; }
+        /**
+         * Get the option value of the topmost layer with the key or return the default value
+         * @param key : key of the option
          * @param def : default value
          * @return option value of the key or default value
          */
-        [[nodiscard]] std::string option_or_def(const string_il keys, const std::string& def) {
-            for(const auto& key : keys) {
-                if(_opts.contains(key)) {
-                    return _opts[key].front();
-                }
-            }
-            return def;
+        [[nodiscard]] std::string option_or_def(const std::string& key, const std::string& def) const {
+            const ParseResult* layer = top(key);
+            return layer != nullptr ? layer->option_or_def(key, def) : def;
         }
         /**
-         * Get the option value of the key
-         * @param keys : list of keys
+         * Get the option value of the topmost layer with the key
+         * @param key : key of the option
          * @return option value of the key
          * @throw std::out_of_range if key is not found
          */
-        [[nodiscard]] std::string option(const string_il keys) {
-            for(const auto& key : keys) {
-                if(_opts.contains(key)) {
-                    return _opts[key].front();
-                }
-            }
-            throw std::out_of_range("argx:ParseResult:Key not found");
+        [[nodiscard]] std::string option(const std::string& key) const {
+            const ParseResult* layer = top(key);
+            if ( layer == nullptr ) ARGX_THROW(std::out_of_range("argx:LayeredResult:Key not found"));
+            return layer->option(key);
         }
         /**
-         * Get the list of options
+         * Get the option values of the topmost layer with the key
          * @param key : key of the option
          * @return list of options
          */
-        [[nodiscard]] string_list options(const std::string& key) {
-            if(_opts.contains(key)) {
-                return _opts[key];
-            }
-            return {};
+        [[nodiscard]] string_list options(const std::string& key) const {
+            const ParseResult* layer = top(key);
+            return layer != nullptr ? layer->options(key) : string_list{};
         }
         /**
-         * Get the list of options
-         * @param keys : list of keys
-         * @return list of options
+         * Check if any layer has the flag
+         * @param flag : flag to check
+         * @return true if the flag exists
          */
-        [[nodiscard]] string_list options(const string_il keys) {
-            string_list result = {};
-            for(const auto& key : keys) {
-                if(_opts.contains(key)) {
-                    result.insert(result.end(), _opts[key].begin(), _opts[key].end());
-                }
-            }
-            return result;
+        [[nodiscard]] bool flag(const std::string& flag) const {
+            return std::ranges::any_of(_layers, [&](const auto& layer) { return layer->flag(flag); });
         }
         /**
-         * Get the map of options
-         * @return map of options
+         * Merge all layers into one result
+         * The merged result is computed once and shared by copies of this stack
+         * until a layer is pushed.
+         * @return merged result
+         */
+        [[nodiscard]] const ParseResult& flatten() const {
+            std::call_once(_cache->once, [&] {
+                ParseResult flat = {{}, {}, {}};
+                for (const auto& layer : _layers) flat = merge(flat, *layer);
+                _cache->result.emplace(std::move(flat));
+            });
+            return *_cache->result;
+        }
+    private:
+        struct cache {
+            std::once_flag once;
+            std::optional<ParseResult> result;
+        };
+
+        [[nodiscard]] const ParseResult* top(const std::string& key) const {
+            for (auto it = _layers.rbegin(); it != _layers.rend(); ++it)
+                if ( (*it)->contains(key) ) return it->get();
+            return nullptr;
+        }
+
+        std::vector<std::shared_ptr<const ParseResult>> _layers;
+        std::shared_ptr<cache> _cache = std::make_shared<cache>();
+    };
+
+    /**
+     * Configuration handle that can be replaced while other threads read it
+     * Readers never lock: a read publishes the current epoch in a reader slot
+     * and loads the current result. Replaced results are freed once every
+     * reader slot has moved past the epoch in which they were retired.
+     * Reclamation only happens inside update() and reclaim(): a replaced result
+     * stays in memory until the next writer call finds it unreachable.
+     * Every live guard occupies a slot. The first 64 are preallocated, guards
+     * held beyond that (deep nesting or many threads) take heap-allocated slots
+     * that are reused afterwards and freed with the handle.
+     */
+    class Reloadable {
+    public:
+        /**
+         * Read access to the current result
+         * The result stays valid until the guard is destroyed, even if it is replaced meanwhile.
          */
-        [[nodiscard]] options_map options() const { return _opts; }
+        class Guard {
+        public:
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+            Guard(Guard&& other) noexcept: _slot(std::exchange(other._slot, nullptr)), _result(other._result) {}
+            ~Guard() { if ( _slot ) _slot->store(0, std::memory_order_release); }
+
+            [[nodiscard]] const FrozenResult& operator*() const { return *_result; }
+            [[nodiscard]] const FrozenResult* operator->() const { return _result; }
+            [[nodiscard]] const FrozenResult& get() const { return *_result; }
+        private:
+            friend class Reloadable;
+            Guard(std::atomic<std::uint64_t>* slot, const FrozenResult* result): _slot(slot), _result(result) {}
+
+            std::atomic<std::uint64_t>* _slot;
+            const FrozenResult* _result;
+        };
+
+        explicit Reloadable(FrozenResult initial): _current(new FrozenResult(std::move(initial))) {}
+        explicit Reloadable(const ParseResult& initial): Reloadable(freeze(initial)) {}
+        Reloadable(const Reloadable&) = delete;
+        Reloadable& operator=(const Reloadable&) = delete;
         /**
-         * Get the size of flags
-         * @return size of flags
+         * Destroy the handle, no guard may be alive
          */
-        [[nodiscard]] size_t flag_size() const { return _flags.size(); }
+        ~Reloadable() {
+            delete _current.load(std::memory_order_relaxed);
+            for (const auto& retired : _retired) delete retired.result;
+            for (auto* slot = _overflow.load(std::memory_order_relaxed); slot; ) delete std::exchange(slot, slot->next);
+        }
+
         /**
-         * Check if the flag exists
-         * @param flag : flag to check
-         * @return true if the flag exists
+         * Read the current result without locking
+         * @return guard keeping the result alive
          */
-        [[nodiscard]] bool flag(const std::string& flag) {
-            return std::ranges::find(_flags, flag) != _flags.end();
+        [[nodiscard]] Guard read() const {
+            static thread_local const size_t hint = next_hint();
+            const std::uint64_t epoch = _epoch.load(std::memory_order_seq_cst);
+            for (size_t i = 0; i < reader_slots; i++)
+                if ( claim(_readers[(hint + i) % reader_slots], epoch) )
+                    return {&_readers[(hint + i) % reader_slots].epoch, _current.load(std::memory_order_seq_cst)};
+            for (auto* slot = _overflow.load(std::memory_order_acquire); slot; slot = slot->next)
+                if ( claim(*slot, epoch) ) return {&slot->epoch, _current.load(std::memory_order_seq_cst)};
+            // every slot is held: publish a new one, already claimed
+            auto* slot = new ReaderSlot;
+            slot->epoch.store(epoch, std::memory_order_relaxed);
+            slot->next = _overflow.load(std::memory_order_relaxed);
+            while ( !_overflow.compare_exchange_weak(slot->next, slot, std::memory_order_seq_cst) ) {}
+            return {&slot->epoch, _current.load(std::memory_order_seq_cst)};
         }
+
         /**
-         * Get the list of flags
-         * @return list of flags
+         * Replace the current result
+         * Readers that already hold a guard keep the old result until they release it.
+         * @param next : new result, built off the hot path
+         */
+        void update(FrozenResult next) {
+            auto* fresh = new FrozenResult(std::move(next));
+            std::lock_guard lock(_writer);
+            const FrozenResult* old = _current.exchange(fresh, std::memory_order_seq_cst);
+            const std::uint64_t epoch = _epoch.fetch_add(1, std::memory_order_seq_cst);
+            _retired.push_back({old, epoch});
+            collect();
+        }
+        /**
+         * Freeze and replace the current result
+         * @param next : new result
+         */
+        void update(const ParseResult& next) { update(freeze(next)); }
+
+        /**
+         * Free replaced results that no reader can see anymore
+         * @return number of results still waiting for readers
+         */
+        size_t reclaim() {
+            std::lock_guard lock(_writer);
+            collect();
+            return _retired.size();
+        }
+    private:
+        static constexpr size_t reader_slots = 64;
+
+        struct alignas(64) ReaderSlot {
+            std::atomic<std::uint64_t> epoch{0}; // 0 when idle
+            ReaderSlot* next = nullptr;          // overflow slots only, set before publication
+        };
+        struct Retired {
+            const FrozenResult* result;
+            std::uint64_t epoch;
+        };
+
+        static size_t next_hint() {
+            static std::atomic<size_t> next{0};
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static bool claim(ReaderSlot& slot, const std::uint64_t epoch) {
+            std::uint64_t expected = 0;
+            return slot.epoch.load(std::memory_order_relaxed) == 0
+                && slot.epoch.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst);
+        }
+
+        void collect() {
+            std::uint64_t oldest = UINT64_MAX;
+            const auto visit = [&](const ReaderSlot& reader) {
+                const std::uint64_t epoch = reader.epoch.load(std::memory_order_seq_cst);
+                if ( epoch != 0 ) oldest = std::min(oldest, epoch);
+            };
+            for (const auto& reader : _readers) visit(reader);
+            for (const auto* slot = _overflow.load(std::memory_order_seq_cst); slot; slot = slot->next) visit(*slot);
+            std::erase_if(_retired, [&](const Retired& retired) {
+                if ( retired.epoch >= oldest ) return false;
+                delete retired.result;
+                return true;
+            });
+        }
+
+        std::atomic<const FrozenResult*> _current;
+        std::atomic<std::uint64_t> _epoch{1};
+        mutable std::array<ReaderSlot, reader_slots> _readers{};
+        mutable std::atomic<ReaderSlot*> _overflow{nullptr};
+        std::mutex _writer;
+        std::vector<Retired> _retired;
+    };
+
+#if defined(__unix__) || defined(__APPLE__)
+    /**
+     * Frozen result mapped read-only from a shared memory file
+     * Every process attached to the same file reads the same physical pages
+     */
+    class SharedResult : public ResultView {
+    public:
+        /**
+         * Map a file created by argx::share
+         * @param fd : file descriptor of the shared image, it stays owned by the caller
+         * @throw std::system_error if the file cannot be mapped
+         * @throw std::invalid_argument if the image is malformed
          */
-        [[nodiscard]] string_list flags() const { return _flags; }
+        explicit SharedResult(const int fd) {
+            struct stat st = {};
+            if ( fstat(fd, &st) != 0 ) ARGX_THROW(std::system_error(errno, std::generic_category(), "argx:SharedResult:fstat"));
+            _size = static_cast<size_t>(st.st_size);
+            void* image = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+            if ( image == MAP_FAILED ) ARGX_THROW(std::system_error(errno, std::generic_category(), "argx:SharedResult:mmap"));
+            _image = image;
+#if ARGX_EXCEPTIONS
+            try {
+                static_cast<ResultView&>(*this) = ResultView(image, _size);
+            } catch (...) {
+                munmap(_image, _size);
+                throw;
+            }
+#else
+            static_cast<ResultView&>(*this) = ResultView(image, _size);
+#endif
+        }
+        SharedResult(const SharedResult&) = delete;
+        SharedResult& operator=(const SharedResult&) = delete;
+        SharedResult(SharedResult&& other) noexcept:
+        ResultView(other), _image(std::exchange(other._image, nullptr)), _size(std::exchange(other._size, 0)) {}
+        SharedResult& operator=(SharedResult&& other) noexcept {
+            if ( this != &other ) {
+                if ( _image ) munmap(_image, _size);
+                static_cast<ResultView&>(*this) = other;
+                _image = std::exchange(other._image, nullptr);
+                _size = std::exchange(other._size, 0);
+            }
+            return *this;
+        }
+        ~SharedResult() { if ( _image ) munmap(_image, _size); }
     private:
-        string_list _args;
-        options_map _opts;
-        string_list _flags;
+        void* _image = nullptr;
+        size_t _size = 0;
     };
 
-    inline ParseResult parse(const int argc, char **argv) {
-        string_list arguments = {};
-        options_map options = {};
-        string_list flags = {};
+    /**
+     * Copy a frozen image into a sealed, read-only shared memory file
+     * Pass the descriptor to children (fork or exec) and attach with argx::SharedResult
+     * @param result : frozen result to share
+     * @return file descriptor owning the shared image
+     * @throw std::system_error if the file cannot be created
+     */
+    inline int share(const ResultView& result) {
+#if defined(__linux__)
+        const int fd = memfd_create("argx", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+        const std::string name = "/argx-" + std::to_string(getpid()) + "-" + std::to_string(reinterpret_cast<std::uintptr_t>(result.data()));
+        const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if ( fd >= 0 ) shm_unlink(name.c_str());
+#endif
+        if ( fd < 0 ) ARGX_THROW(std::system_error(errno, std::generic_category(), "argx:share:create"));
+        const auto fail = [fd](const char* what) {
+            const int error = errno;
+            close(fd);
+            ARGX_THROW(std::system_error(error, std::generic_category(), what));
+        };
+        if ( ftruncate(fd, static_cast<off_t>(result.size())) != 0 ) fail("argx:share:ftruncate");
+        void* image = mmap(nullptr, result.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if ( image == MAP_FAILED ) fail("argx:share:mmap");
+        std::memcpy(image, result.data(), result.size());
+        munmap(image, result.size());
+#if defined(__linux__)
+        if ( fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0 ) fail("argx:share:seal");
+#endif
+        return fd;
+    }
+#endif
 
-        std::optional<std::string> previous = std::nullopt;
+#if defined(__linux__)
+    /**
+     * Parsed command line of one process
+     */
+    struct ProcessCommand {
+        int pid;
+        ParseResult result;
+    };
 
-        for (int i = 0; i < argc; i++) {
-            std::string target = argv[i];
+    namespace detail {
+        /**
+         * Read a whole file below dir into the reused buffer
+         */
+        inline bool read_at(const int dir, const char* path, std::string& buffer) {
+            const int fd = openat(dir, path, O_RDONLY | O_CLOEXEC);
+            if ( fd < 0 ) return false;
+            size_t size = 0;
+            for (;;) {
+                if ( size == buffer.size() ) buffer.resize(std::max<size_t>(4096, buffer.size() * 2));
+                const ssize_t n = read(fd, buffer.data() + size, buffer.size() - size);
+                if ( n < 0 && errno == EINTR ) continue;
+                if ( n <= 0 ) {
+                    close(fd);
+                    buffer.resize(n == 0 ? size : 0);
+                    return n == 0;
+                }
+                size += static_cast<size_t>(n);
+            }
+        }
 
-            const size_t prefix = target.find_first_not_of('-');
-            if (prefix == target.length()) continue;
-            target.erase(0, prefix);
+        inline std::vector<ProcessCommand> scan_processes(const Schema* schema, unsigned threads) {
+            const int proc = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if ( proc < 0 ) ARGX_THROW(std::system_error(errno, std::generic_category(), "argx:scan_processes:open"));
+            const int listing = dup(proc); // closedir closes it, proc stays open for the workers
+            DIR* dir = listing >= 0 ? fdopendir(listing) : nullptr;
+            if ( dir == nullptr ) {
+                const int error = errno;
+                if ( listing >= 0 ) close(listing);
+                close(proc);
+                ARGX_THROW(std::system_error(error, std::generic_category(), "argx:scan_processes:opendir"));
+            }
+            std::vector<int> pids;
+            while ( const dirent* entry = readdir(dir) ) {
+                int pid = 0;
+                const auto [end, error] = std::from_chars(entry->d_name, entry->d_name + std::strlen(entry->d_name), pid);
+                if ( error == std::errc() && *end == '\0' ) pids.push_back(pid);
+            }
+            closedir(dir);
 
-            if (prefix>=2) { // Flag
-                previous = std::nullopt;
-                flags.push_back(target);
-            } else if (prefix==1) { // Option
-                if (!options.contains(target))
-                    options[target] = {};
-                previous = target;
-            } else { // Argument
-                if (previous.has_value()) {
-                    options[previous.value()].push_back(target);
-                    previous = std::nullopt;
-                }else {
-                    arguments.push_back(target);
+            if ( threads == 0 ) threads = std::max(1u, std::thread::hardware_concurrency());
+            threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, pids.size() / 64)));
+            std::atomic<size_t> next = 0;
+            std::vector<std::vector<ProcessCommand>> found(threads);
+            const auto work = [&](std::vector<ProcessCommand>& out) {
+                constexpr size_t batch = 64; // pids claimed per atomic step
+                std::string buffer;
+                char path[32];
+                for (size_t first; (first = next.fetch_add(batch, std::memory_order_relaxed)) < pids.size();) {
+                    for (size_t i = first; i < std::min(first + batch, pids.size()); i++) {
+                        std::snprintf(path, sizeof(path), "%d/cmdline", pids[i]);
+                        if ( !read_at(proc, path, buffer) || buffer.empty() ) continue; // Gone, or a kernel thread
+                        const NulSeparated tokens(buffer);
+                        if ( schema == nullptr ) {
+                            out.push_back({pids[i], parse(tokens)});
+                        } else {
+                            Collector collector(*schema);
+                            if ( feed(collector, tokens, schema->utf8()) ) continue; // Validated while collecting
+                            out.push_back({pids[i], collector.finish()});
+                        }
+                    }
+                }
+            };
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+#if ARGX_EXCEPTIONS
+            // A failing worker stops the claims, its exception is rethrown once every thread is joined
+            std::exception_ptr failure;
+            std::mutex failure_mutex;
+            const auto guarded = [&](std::vector<ProcessCommand>& out) {
+                try {
+                    work(out);
+                } catch (...) {
+                    next.store(pids.size(), std::memory_order_relaxed);
+                    std::lock_guard lock(failure_mutex);
+                    if ( !failure ) failure = std::current_exception();
+                }
+            };
+            for (unsigned t = 1; t < threads; t++) {
+                try {
+                    workers.emplace_back(guarded, std::ref(found[t]));
+                } catch (...) {
+                    break; // Stop spawning, the threads already running claim the remaining pids
                 }
             }
+            guarded(found[0]);
+            for (auto& worker : workers) worker.join();
+            close(proc);
+            if ( failure ) std::rethrow_exception(failure);
+#else
+            for (unsigned t = 1; t < threads; t++) workers.emplace_back(work, std::ref(found[t]));
+            work(found[0]);
+            for (auto& worker : workers) worker.join();
+            close(proc);
+#endif
+
+            std::vector<ProcessCommand> result;
+            for (auto& part : found) std::ranges::move(part, std::back_inserter(result));
+            std::ranges::sort(result, {}, &ProcessCommand::pid);
+            return result;
         }
+    }
+
+    /**
+     * Parse the command line of every process in /proc
+     * Worker threads claim pids in batches and reuse one read buffer each;
+     * every pid still costs one open, read and close of its cmdline.
+     * Processes that exit during the scan and kernel threads are skipped.
+     * @param threads : number of worker threads, 0 for one per hardware thread
+     * @return command lines ordered by pid
+     * @throw std::system_error if /proc cannot be read
+     * @throw any exception of a worker, e.g. std::bad_alloc, after every worker has stopped
+     */
+    inline std::vector<ProcessCommand> scan_processes(const unsigned threads = 0) {
+        return detail::scan_processes(nullptr, threads);
+    }
 
-        return {arguments, options, flags};
+    /**
+     * Parse the command line of every process in /proc with a schema
+     * Processes whose command line is not valid UTF-8 are skipped when the schema requires UTF-8.
+     * @param schema : known options and flags, must outlive the results
+     * @param threads : number of worker threads, 0 for one per hardware thread
+     * @return command lines ordered by pid
+     * @throw std::system_error if /proc cannot be read
+     */
+    inline std::vector<ProcessCommand> scan_processes(const Schema& schema, const unsigned threads = 0) {
+        return detail::scan_processes(&schema, threads);
     }
+#endif
 }
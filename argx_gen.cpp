@@ -0,0 +1,331 @@
+/*
+ * argx_gen.cpp
+ * Generates a specialized parser header from a command line spec
+ *
+ * Usage:
+ *     argx_gen spec.argx output.h
+ *
+ * Spec format, one declaration per line, # starts a comment:
+ *     namespace cli
+ *     struct Config
+ *     option threads,t,j int N "Number of worker threads"
+ *     option id int[] ID "Ids to process, may repeat"
+ *     flag fast,f "Use the fast path"
+ *     arguments files
+ *
+ * Types: int, long, double, string, with [] to collect every value.
+ * Member names are the first alias with other characters replaced by '_';
+ * they must not be C++ keywords or repeat another member. An alias is given
+ * without dashes and belongs to one option or one flag. Namespace and struct
+ * names must be C++ identifiers, the namespace may be nested with ::.
+ */
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include "argx.h"
+
+using namespace std;
+
+struct Declaration {
+    bool flag = false;
+    vector<string> aliases;
+    string member;
+    string type;
+    string value_name;
+    string help;
+};
+
+struct Spec {
+    string ns = "cli";
+    string name = "Config";
+    vector<Declaration> options;
+    string arguments;
+};
+
+static vector<string> split_words(const string& line, const int number) {
+    vector<string> words;
+    size_t i = 0;
+    while (i < line.size()) {
+        if (isspace(static_cast<unsigned char>(line[i]))) { i++; continue; }
+        if (line[i] == '#') break;
+        string word;
+        if (line[i] == '"') {
+            for (i++; i < line.size() && line[i] != '"'; i++) {
+                if (line[i] == '\\' && i + 1 < line.size()) i++;
+                word += line[i];
+            }
+            if (i >= line.size()) throw runtime_error("line " + to_string(number) + ": unterminated string");
+            i++;
+        } else {
+            while (i < line.size() && !isspace(static_cast<unsigned char>(line[i]))) word += line[i++];
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+static bool is_keyword(const string& name) {
+    static const set<string> keywords = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+        "char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval", "constexpr",
+        "constinit", "const_cast", "continue", "co_await", "co_return", "co_yield", "decltype", "default", "delete",
+        "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+        "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+        "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast",
+        "requires", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+        "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename",
+        "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq",
+    };
+    return keywords.contains(name);
+}
+
+static string member_name(const string& alias, const int number) {
+    string name = alias;
+    for (auto& c : name)
+        if (!isalnum(static_cast<unsigned char>(c))) c = '_';
+    if (name.empty() || isdigit(static_cast<unsigned char>(name[0]))) name = "_" + name;
+    if (is_keyword(name)) throw runtime_error("line " + to_string(number) + ": member " + name + " is a C++ keyword");
+    return name;
+}
+
+// namespace and struct names are written as given, so they must already be identifiers
+static string identifier(const string& name, const string& what, const int number) {
+    const auto fail = [&](const string& why) { throw runtime_error("line " + to_string(number) + ": " + what + " " + name + " " + why); };
+    if (name.empty() || isdigit(static_cast<unsigned char>(name[0]))) fail("is not an identifier");
+    for (const char c : name)
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_') fail("is not an identifier");
+    if (is_keyword(name)) fail("is a C++ keyword");
+    return name;
+}
+
+static string cpp_type(const string& type, const int number) {
+    static const map<string, string> types = {
+        {"int", "int"}, {"long", "long long"}, {"double", "double"}, {"string", "std::string"},
+    };
+    const bool list = type.ends_with("[]");
+    const auto it = types.find(list ? type.substr(0, type.size() - 2) : type);
+    if (it == types.end()) throw runtime_error("line " + to_string(number) + ": unknown type " + type);
+    return list ? "std::vector<" + it->second + ">" : it->second;
+}
+
+static Spec read_spec(istream& in) {
+    Spec spec;
+    map<string, int> members; // member name and the line declaring it
+    map<string, int> option_aliases, flag_aliases; // alias and the line declaring it
+    string line;
+    for (int number = 1; getline(in, line); number++) {
+        const auto words = split_words(line, number);
+        if (words.empty()) continue;
+        const auto fail = [&](const string& what) { throw runtime_error("line " + to_string(number) + ": " + what); };
+        const auto declare = [&](const string& member) {
+            if (const auto [it, added] = members.emplace(member, number); !added)
+                fail("member " + member + " already declared on line " + to_string(it->second));
+            return member;
+        };
+        if (words[0] == "namespace" && words.size() == 2) {
+            for (size_t first = 0, end; first <= words[1].size(); first = end + 2) {
+                end = min(words[1].find("::", first), words[1].size());
+                identifier(words[1].substr(first, end - first), "namespace", number);
+            }
+            spec.ns = words[1];
+        } else if (words[0] == "struct" && words.size() == 2) {
+            spec.name = identifier(words[1], "struct", number);
+        } else if (words[0] == "arguments" && words.size() == 2) {
+            if (!spec.arguments.empty()) fail("arguments already declared");
+            spec.arguments = declare(member_name(words[1], number));
+        } else if ((words[0] == "option" && words.size() >= 3 && words.size() <= 5) || (words[0] == "flag" && words.size() >= 2 && words.size() <= 3)) {
+            Declaration declaration;
+            declaration.flag = words[0] == "flag";
+            stringstream aliases(words[1]);
+            auto& declared = declaration.flag ? flag_aliases : option_aliases;
+            for (string alias; getline(aliases, alias, ',');) {
+                if (alias.empty()) continue;
+                if (alias[0] == '-') fail("alias " + alias + " must be given without dashes");
+                if (const auto [it, added] = declared.emplace(alias, number); !added)
+                    fail("alias " + alias + " already declared on line " + to_string(it->second));
+                declaration.aliases.push_back(alias);
+            }
+            if (declaration.aliases.empty()) fail("missing name");
+            declaration.member = declare(member_name(declaration.aliases.front(), number));
+            if (declaration.flag) {
+                declaration.type = "bool";
+                if (words.size() == 3) declaration.help = words[2];
+            } else {
+                declaration.type = cpp_type(words[2], number);
+                if (words.size() == 4) declaration.help = words[3];
+                if (words.size() == 5) {
+                    declaration.value_name = words[3];
+                    declaration.help = words[4];
+                }
+            }
+            spec.options.push_back(declaration);
+        } else {
+            fail("cannot parse: " + line);
+        }
+    }
+    return spec;
+}
+
+static string quote(const string_view text) {
+    string out = "\"";
+    for (const char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static string char_literal(const char c) {
+    if (c == '\'' || c == '\\') return string("'\\") + c + "'";
+    return string("'") + c + "'";
+}
+
+// switch on length, then on the first character, then one comparison
+static void emit_lookup(ostream& out, const string& function, const vector<pair<string, int>>& names) {
+    map<size_t, map<char, vector<pair<string, int>>>> buckets;
+    for (const auto& [name, index] : names) buckets[name.size()][name[0]].push_back({name, index});
+    out << "        inline int " << function << "(const std::string_view name) {\n";
+    out << "            if (name.empty()) return -1;\n";
+    out << "            switch (name.size()) {\n";
+    for (const auto& [size, by_char] : buckets) {
+        out << "                case " << size << ":\n";
+        out << "                    switch (name[0]) {\n";
+        for (const auto& [c, entries] : by_char) {
+            out << "                        case " << char_literal(c) << ":\n";
+            for (const auto& [name, index] : entries)
+                out << "                            if (name == " << quote(name) << ") return " << index << ";\n";
+            out << "                            break;\n";
+        }
+        out << "                    }\n";
+        out << "                    break;\n";
+    }
+    out << "            }\n";
+    out << "            return -1;\n";
+    out << "        }\n";
+}
+
+static void emit(ostream& out, const Spec& spec, const string& source) {
+    vector<string> left;
+    vector<pair<string, int>> option_names, flag_names;
+    vector<string> completions;
+    for (size_t i = 0; i < spec.options.size(); i++) {
+        const auto& declaration = spec.options[i];
+        string column;
+        for (const auto& alias : declaration.aliases) {
+            const string dashed = (declaration.flag ? "--" : "-") + alias;
+            if (!column.empty()) column += ", ";
+            column += dashed;
+            completions.push_back(dashed);
+            (declaration.flag ? flag_names : option_names).push_back({alias, static_cast<int>(i)});
+        }
+        if (!declaration.value_name.empty()) column += " <" + declaration.value_name + ">";
+        left.push_back(column);
+    }
+    vector<argx::HelpLine> lines;
+    for (size_t i = 0; i < spec.options.size(); i++) lines.push_back({left[i], spec.options[i].help});
+    string help;
+    argx::detail::format_help(lines, 80, [&](const string_view text) { help += text; });
+
+    out << "// Generated by argx_gen from " << source << ", do not edit.\n";
+    out << "#pragma once\n\n";
+    out << "#include <array>\n#include <string>\n#include <string_view>\n#include <utility>\n#include <vector>\n#include \"argx.h\"\n\n";
+    out << "namespace " << spec.ns << " {\n\n";
+    out << "    struct " << spec.name << " {\n";
+    for (const auto& declaration : spec.options)
+        out << "        " << declaration.type << " " << declaration.member << " = {};\n";
+    if (!spec.arguments.empty())
+        out << "        std::vector<std::string> " << spec.arguments << " = {};\n";
+    out << "    };\n\n";
+
+    out << "    inline constexpr std::string_view help = " << quote(help) << ";\n\n";
+    out << "    inline constexpr std::array<std::string_view, " << completions.size() << "> completions = {";
+    for (size_t i = 0; i < completions.size(); i++) out << (i ? ", " : "") << quote(completions[i]);
+    out << "};\n\n";
+
+    out << "    namespace detail {\n";
+    emit_lookup(out, "find_option", option_names);
+    out << "\n";
+    emit_lookup(out, "find_flag", flag_names);
+    out << "    }\n\n";
+
+    out << "    inline " << spec.name << " parse(const int argc, char **argv) {\n";
+    out << "        " << spec.name << " result = {};\n";
+    const bool scalars = ranges::any_of(spec.options, [](const Declaration& declaration) {
+        return !declaration.flag && !declaration.type.starts_with("std::vector");
+    });
+    if (scalars) out << "        std::array<bool, " << spec.options.size() << "> assigned = {}; // scalars keep the first value\n";
+    out << "        bool after_option = false;\n";
+    out << "        int pending = -1;\n";
+    out << "        for (int i = 0; i < argc; i++) {\n";
+    out << "            const auto tok = argx::classify(argv[i]);\n";
+    out << "            if (!tok) continue;\n";
+    out << "            switch (tok->kind) {\n";
+    out << "                case argx::TokenKind::flag:\n";
+    out << "                    after_option = false;\n";
+    out << "                    switch (detail::find_flag(tok->name)) {\n";
+    for (size_t i = 0; i < spec.options.size(); i++)
+        if (spec.options[i].flag)
+            out << "                        case " << i << ": result." << spec.options[i].member << " = true; break;\n";
+    out << "                    }\n";
+    out << "                    break;\n";
+    out << "                case argx::TokenKind::option:\n";
+    out << "                    after_option = true;\n";
+    out << "                    pending = detail::find_option(tok->name);\n";
+    out << "                    break;\n";
+    out << "                case argx::TokenKind::argument:\n";
+    out << "                    if (after_option) {\n";
+    out << "                        switch (pending) {\n";
+    for (size_t i = 0; i < spec.options.size(); i++) {
+        const auto& declaration = spec.options[i];
+        if (declaration.flag) continue;
+        out << "                            case " << i << ":\n";
+        if (!declaration.type.starts_with("std::vector"))
+            out << "                                if (std::exchange(assigned[" << i << "], true)) break;\n";
+        out << "                                argx::assign(result." << declaration.member << ", tok->name, "
+            << quote(declaration.aliases.front()) << ");\n";
+        out << "                                break;\n";
+    }
+    out << "                        }\n";
+    if (!spec.arguments.empty())
+        out << "                    } else {\n                        result." << spec.arguments << ".emplace_back(tok->name);\n";
+    out << "                    }\n";
+    out << "                    after_option = false;\n";
+    out << "                    pending = -1;\n";
+    out << "                    break;\n";
+    out << "                case argx::TokenKind::value: // classify never binds values\n";
+    out << "                    break;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        return result;\n";
+    out << "    }\n";
+    out << "}\n";
+}
+
+int main( int argc, char** argv ) {
+    if (argc != 3) {
+        cerr << "Usage: argx_gen spec output.h" << endl;
+        return 2;
+    }
+    ifstream in(argv[1]);
+    if (!in) {
+        cerr << "argx_gen: cannot open " << argv[1] << endl;
+        return 1;
+    }
+    try {
+        const Spec spec = read_spec(in);
+        stringstream out;
+        emit(out, spec, argv[1]);
+        ofstream file(argv[2]);
+        file << out.str();
+        if (!file) throw runtime_error(string("cannot write ") + argv[2]);
+    } catch (const exception& e) {
+        cerr << "argx_gen: " << argv[1] << ": " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,24 @@
+/*
+ * argx_gen_example.cpp
+ * Uses the parser generated from example.argx
+ *
+ * Usage:
+ *     argx_gen_example -threads 4 -id 1 -id 2 --fast in.txt
+ */
+#include <iostream>
+#include "example.h"
+
+using namespace std;
+
+int main( int argc, char** argv ) {
+    const cli::Config config = cli::parse(argc, argv);
+    if ( config.files.size() < 2 ) { // files[0] is the program
+        cout << cli::help;
+        return 0;
+    }
+    cout << "threads: " << config.threads << endl;
+    cout << "out-dir: " << config.out_dir << endl;
+    cout << "fast: " << config.fast << endl;
+    for (const auto id : config.id) cout << "id: " << id << endl;
+    for (const auto& file : config.files) cout << "file: " << file << endl;
+}
@@ -0,0 +1,109 @@
+/*
+ * argx_stress.cpp
+ * Concurrent read stress test and benchmark of a shared const ParseResult,
+ * and of lookups that miss through the expected and the throwing accessors,
+ * plus regression checks that are most useful under the sanitizers
+ *
+ * Usage:
+ *     argx_stress -threads 8 -iterations 100000
+ *
+ * Build with -fsanitize=thread to check that concurrent readers are race free.
+ */
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "argx.h"
+
+using namespace std;
+
+static double seconds_since(const chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Every thread reads the same const result; any mismatch counts as a failure
+static bool stress_reads(const unsigned threads, const long iterations) {
+    argx::Schema schema;
+    const auto threads_id = schema.add({"threads", "t"});
+    const auto fast_id = schema.add_flag({"fast", "f"});
+    vector<string> tokens = {"prog", "in.txt", "-t", "8", "-name", "job", "-tag", "a", "-tag", "b", "--fast", "--verbose", "out.txt"};
+    const argx::ParseResult result = argx::parse(schema, tokens);
+
+    atomic<long> failures = 0;
+    const auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            long failed = 0;
+            for (long i = 0; i < iterations; i++) {
+                failed += result.option(threads_id) != "8";
+                failed += result.option("name") != "job";
+                failed += result.options("tag").size() != 2;
+                failed += !result.flag(fast_id) || !result.flag("verbose") || result.flag("quiet");
+                failed += result.contains("missing") || result.argument(2) != "out.txt";
+            }
+            failures += failed;
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    const double elapsed = seconds_since(start);
+    const double reads = 8.0 * threads * iterations; // lookups per iteration above
+    cout << "concurrent reads: " << threads << " threads, " << reads / elapsed / 1e6 << " M reads/s, "
+         << failures << " failures" << endl;
+    return failures == 0;
+}
+
+// The same missing lookups through the expected accessors, then through the throwing ones
+static bool bench_miss_path(const long iterations) {
+    argx::Schema schema;
+    const auto threads_id = schema.add({"threads", "t"});
+    vector<string> tokens = {"prog", "in.txt", "-name", "job"};
+    const argx::ParseResult result = argx::parse(schema, tokens);
+
+    long misses = 0;
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        misses += !result.try_option("missing");
+        misses += !result.try_option(threads_id);
+        misses += !result.try_argument(5);
+    }
+    const double expected_elapsed = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        try { (void)result.option("missing"); } catch (const out_of_range&) { misses++; }
+        try { (void)result.option(threads_id); } catch (const out_of_range&) { misses++; }
+        try { (void)result.argument(5); } catch (const out_of_range&) { misses++; }
+    }
+    const double throwing_elapsed = seconds_since(start);
+    const double lookups = 3.0 * iterations;
+    cout << "miss path: expected " << lookups / expected_elapsed / 1e6 << " M lookups/s, throwing "
+         << lookups / throwing_elapsed / 1e6 << " M lookups/s" << endl;
+    return misses == 6 * iterations;
+}
+
+// Help text cached before a description changes must be rebuilt, not read through stale views
+static bool help_after_update() {
+    argx::Schema schema;
+    const auto threads_id = schema.add({"threads", "t"});
+    argx::Help help(schema);
+    schema.help(threads_id, "Number of worker threads used for every stage of the pipeline", "N");
+    (void)help.text(60);
+    schema.help(threads_id, "Threads per stage, defaults to one per hardware thread of the machine", "COUNT");
+    const string& text = help.text(70);
+    const bool ok = text.find("COUNT") != string::npos && text.find("Threads per stage") != string::npos;
+    cout << "help after update: " << (ok ? "ok" : "stale") << endl;
+    return ok;
+}
+
+int main( int argc, char** argv ) {
+    const auto args = argx::parse(argc, argv);
+    const unsigned threads = stoul(args.option_or_def({"threads", "t"}, to_string(max(1u, thread::hardware_concurrency()))));
+    const long iterations = stol(args.option_or_def({"iterations", "n"}, "100000"));
+
+    bool ok = stress_reads(threads, iterations);
+    ok = bench_miss_path(iterations) && ok;
+    ok = help_after_update() && ok;
+    return ok ? 0 : 1;
+}